@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cmath>
+
+#include "AdaptiveSampler.hpp"
+#include "ElectricField.hpp"
+#include "TaskScheduler.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    const size_t chunkSize = 512;   // Points per task when a level is large
+
+    // Child k of a cell is centred at center + childOffsets[k] * halfSize
+    const glm::vec2 childOffsets[4] = {
+        glm::vec2(-0.5f, -0.5f), glm::vec2(0.5f, -0.5f), glm::vec2(-0.5f, 0.5f), glm::vec2(0.5f, 0.5f)
+    };
+}
+
+void AdaptiveSampler::setBounds(float newXMin, float newXMax, float newYMin, float newYMax) {
+    if (newXMin == xMin && newXMax == xMax && newYMin == yMin && newYMax == yMax) return;
+    xMin = newXMin;
+    xMax = newXMax;
+    yMin = newYMin;
+    yMax = newYMax;
+    valid = false;
+}
+
+void AdaptiveSampler::setCellSizes(float newRootSize, float newMinSize) {
+    newRootSize = std::max(newRootSize, 1e-4f);
+    newMinSize = std::max(newMinSize, 1e-5f);
+    if (newRootSize == rootSize && newMinSize == minSize) return;
+    rootSize = newRootSize;
+    minSize = newMinSize;
+    valid = false;
+}
+
+void AdaptiveSampler::setTolerances(float direction, float magnitude) {
+    direction = std::max(direction, 1e-3f);
+    magnitude = std::max(magnitude, 1e-6f);
+    if (direction == directionTolerance && magnitude == magnitudeTolerance) return;
+    directionTolerance = direction;
+    magnitudeTolerance = magnitude;
+    valid = false;
+}
+
+void AdaptiveSampler::evaluate(const VectorField& field, size_t count) {
+    fieldX.resize(count);
+    fieldY.resize(count);
+    if (count == 0) return;
+
+    TaskScheduler::global().parallelFor(0, count, chunkSize, [&](size_t begin, size_t end) {
+        field.sample(Span<const float>(pointX.data() + begin, end - begin),
+                     Span<const float>(pointY.data() + begin, end - begin),
+                     Span<float>(fieldX.data() + begin, end - begin),
+                     Span<float>(fieldY.data() + begin, end - begin));
+    });
+}
+
+float AdaptiveSampler::difference(glm::vec2 a, glm::vec2 b) const {
+    float lengthA = glm::length(a), lengthB = glm::length(b);
+    float result = std::abs(std::log(1.0f + lengthA) - std::log(1.0f + lengthB)) / magnitudeTolerance;
+    if (lengthA > 0.0f && lengthB > 0.0f) {
+        float cosine = std::min(1.0f, std::max(-1.0f, glm::dot(a, b) / (lengthA * lengthB)));
+        result = std::max(result, std::acos(cosine) / directionTolerance);
+    }
+    return result;
+}
+
+void AdaptiveSampler::setPriority(Cell& cell, float variation) const {
+    float size = 2.0f * std::min(cell.halfSize.x, cell.halfSize.y);
+    // A cleared cell larger than the clearance has visible parts to show
+    if (cell.cleared) variation = size > clearance ? 2.0f : 0.0f;
+    bool splittable = std::min(cell.halfSize.x, cell.halfSize.y) >= minSize;
+    cell.priority = splittable && variation > 1.0f ? variation * size * size : 0.0f;
+}
+
+bool AdaptiveSampler::isCleared(glm::vec2 point) const {
+    return clearOf && clearance > 0.0f && clearOf->hasChargeWithin(point.x, point.y, clearance);
+}
+
+bool AdaptiveSampler::update(const VectorField& field, uint64_t revision,
+                             const ElectricField* newClearOf, float newClearance) {
+    if (valid && &field == lastField && revision == lastRevision
+        && newClearOf == clearOf && newClearance == clearance) return false;
+    PROFILE_ZONE("AdaptiveSampler::update");
+    clearOf = newClearOf;
+    clearance = newClearance;
+
+    // Root cells on a lattice fixed in the world, so panning the bounds
+    // keeps the arrows in place; the outer cells may stick out a little.
+    // Doubled until they fit the budget (a view zoomed far out), which
+    // keeps them on the lattice.
+    float size = rootSize;
+    float firstX, firstY;
+    size_t columns, rows;
+    while (true) {
+        firstX = std::floor(xMin / size) * size;
+        firstY = std::floor(yMin / size) * size;
+        columns = static_cast<size_t>(std::max(1.0f, std::ceil((xMax - firstX) / size)));
+        rows = static_cast<size_t>(std::max(1.0f, std::ceil((yMax - firstY) / size)));
+        if (static_cast<double>(columns) * rows <= budget) break;
+        size *= 2.0f;
+    }
+    glm::vec2 rootHalf(0.5f * size);
+
+    cells.clear();
+    pointX.clear();
+    pointY.clear();
+    for (size_t c = 0; c < columns; c++) {
+        for (size_t r = 0; r < rows; r++) {
+            Cell cell = {};
+            cell.center = glm::vec2(firstX + (2 * c + 1) * rootHalf.x, firstY + (2 * r + 1) * rootHalf.y);
+            cell.halfSize = rootHalf;
+            cell.cleared = isCleared(cell.center);
+            cells.push_back(cell);
+            pointX.push_back(cell.center.x);
+            pointY.push_back(cell.center.y);
+        }
+    }
+    evaluate(field, cells.size());
+    evaluations = cells.size();
+
+    // The variation inside a cell is estimated from what is already known
+    // around it: half the difference to a neighbour one cell away, since
+    // the cell's own edges are half a cell from its arrow
+    for (size_t i = 0; i < cells.size(); i++) cells[i].field = glm::vec2(fieldX[i], fieldY[i]);
+    for (size_t c = 0; c < columns; c++) {
+        for (size_t r = 0; r < rows; r++) {
+            Cell& cell = cells[c * rows + r];
+            float variation = 0.0f;
+            const size_t neighbours[4][2] = {{c - 1, r}, {c + 1, r}, {c, r - 1}, {c, r + 1}};
+            for (const auto& n : neighbours) {
+                if (n[0] >= columns || n[1] >= rows) continue;   // Wraps around for -1
+                const Cell& other = cells[n[0] * rows + n[1]];
+                if (!other.cleared) variation = std::max(variation, 0.5f * difference(cell.field, other.field));
+            }
+            setPriority(cell, variation);
+        }
+    }
+
+    while (cells.size() + 3 <= budget) {
+        order.clear();
+        for (size_t i = 0; i < cells.size(); i++) {
+            if (cells[i].priority > 0.0f) order.push_back(i);
+        }
+        if (order.empty()) break;
+
+        // The worst cells of this round; a quarter of the candidates per
+        // round keeps the ranking close to one split at a time
+        size_t room = (budget - cells.size()) / 3;
+        size_t splits = std::min(room, std::max<size_t>(64, order.size() / 4));
+        if (splits < order.size()) {
+            std::nth_element(order.begin(), order.begin() + splits, order.end(),
+                             [this](size_t a, size_t b) { return cells[a].priority > cells[b].priority; });
+            order.resize(splits);
+        }
+
+        // Their children, in one batch
+        pointX.clear();
+        pointY.clear();
+        for (size_t index : order) {
+            const Cell& cell = cells[index];
+            for (const glm::vec2& offset : childOffsets) {
+                glm::vec2 child = cell.center + offset * cell.halfSize;
+                pointX.push_back(child.x);
+                pointY.push_back(child.y);
+            }
+        }
+        evaluate(field, pointX.size());
+        evaluations += pointX.size();
+
+        // Each split cell becomes its first child and the other three are
+        // appended. A child's variation comes from its siblings (one child
+        // away) and the parent's arrow at their shared corner.
+        for (size_t p = 0; p < order.size(); p++) {
+            Cell parent = cells[order[p]];
+            Cell children[4];
+            for (size_t k = 0; k < 4; k++) {
+                children[k] = Cell{};
+                children[k].center = parent.center + childOffsets[k] * parent.halfSize;
+                children[k].halfSize = 0.5f * parent.halfSize;
+                children[k].field = glm::vec2(fieldX[4 * p + k], fieldY[4 * p + k]);
+                children[k].cleared = isCleared(children[k].center);
+            }
+            for (size_t k = 0; k < 4; k++) {
+                float variation = 0.0f;
+                for (size_t sibling : {k ^ 1, k ^ 2}) {
+                    if (children[sibling].cleared) continue;
+                    variation = std::max(variation, 0.5f * difference(children[k].field, children[sibling].field));
+                }
+                if (!parent.cleared) {
+                    variation = std::max(variation, 0.7f * difference(children[k].field, parent.field));
+                }
+                setPriority(children[k], variation);
+            }
+
+            cells[order[p]] = children[0];
+            for (size_t k = 1; k < 4; k++) cells.push_back(children[k]);
+        }
+    }
+
+    samples.clear();
+    for (const Cell& cell : cells) {
+        if (cell.cleared) continue;
+        samples.push_back(ArrowSample{cell.center, cell.field, 2.0f * std::min(cell.halfSize.x, cell.halfSize.y)});
+    }
+
+    lastField = &field;
+    lastRevision = revision;
+    valid = true;
+    version++;
+    return true;
+}
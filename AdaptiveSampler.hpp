@@ -0,0 +1,103 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VectorField.hpp"
+
+class ElectricField;
+
+// One arrow of the adaptive sampling: a leaf cell's centre, the field
+// there and the cell's size (to scale the arrow so neighbours never overlap)
+struct ArrowSample {
+    glm::vec2 position;
+    glm::vec2 field;
+    float cellSize;
+};
+
+// Arrow positions on a quadtree instead of a fixed grid.
+// The view is covered with square root cells, each with one arrow
+// at its centre. A cell's variation is estimated from fields already
+// known around it (grid neighbours for roots, siblings and the parent for
+// split cells): the turn in direction and the change in log magnitude,
+// relative to the tolerances. Cells over tolerance are split worst first
+// (weighted by area, so one big wrong arrow outranks a tiny one) until
+// the arrow budget runs out, and each split evaluates only the four new
+// arrows. Arrows thus gather where the field bends (around charges) and a
+// flat region keeps a single large arrow. The splits are made in rounds,
+// each one batch of field evaluations split across the task scheduler.
+class AdaptiveSampler {
+public:
+    // Area to cover; a change resamples. Root cells are aligned to multiples
+    // of the root size, so overlapping views share their arrows.
+    void setBounds(float xMin, float xMax, float yMin, float yMax);
+
+    // Size of the root cells and of the smallest cell a split may produce.
+    // Roots are doubled while the bounds need more of them than the budget.
+    void setCellSizes(float rootSize, float minSize);
+
+    // Most arrows per update, roots included
+    void setBudget(size_t arrows) { budget = arrows > 0 ? arrows : 1; }
+    size_t getBudget() const { return budget; }
+
+    // Split when the field direction within a cell turns more than
+    // `direction` radians, or its log(1 + |E|) changes by more than `magnitude`
+    void setTolerances(float direction, float magnitude);
+
+    // Resamples field unless it is the same field at the same revision as
+    // last time (VectorFields have no revision; pass 0 for static ones).
+    // Points within clearance of a charge of clearOf get no arrow and do
+    // not count as variation, so no budget goes into them. Returns whether
+    // the samples changed.
+    bool update(const VectorField& field, uint64_t revision,
+                const ElectricField* clearOf = nullptr, float clearance = 0.0f);
+
+    const std::vector<ArrowSample>& getSamples() const { return samples; }
+
+    // Field evaluations made by the last resampling (for diagnostics)
+    size_t getEvaluations() const { return evaluations; }
+
+    // Bumped whenever the samples change
+    uint64_t getVersion() const { return version; }
+
+private:
+    struct Cell {
+        glm::vec2 center;
+        glm::vec2 halfSize;
+        glm::vec2 field;
+        float priority;            // > 0 when the cell should split
+        bool cleared;              // Centre too close to a charge
+    };
+
+    float xMin = -1.0f, xMax = 1.0f, yMin = -1.0f, yMax = 1.0f;
+    float rootSize = 0.25f;
+    float minSize = 0.02f;
+    size_t budget = 800;
+    float directionTolerance = 0.35f;  // About 20 degrees
+    float magnitudeTolerance = 0.5f;
+
+    std::vector<ArrowSample> samples;
+    size_t evaluations = 0;
+    uint64_t version = 0;
+
+    const VectorField* lastField = nullptr;
+    uint64_t lastRevision = 0;
+    const ElectricField* clearOf = nullptr;
+    float clearance = 0.0f;
+    bool valid = false;
+
+    // Working storage, kept between updates so steady frames do not allocate
+    std::vector<Cell> cells;
+    std::vector<float> pointX, pointY, fieldX, fieldY;
+    std::vector<size_t> order;
+
+    void evaluate(const VectorField& field, size_t count);
+    bool isCleared(glm::vec2 point) const;
+
+    // How far apart two field values are, relative to the tolerances
+    float difference(glm::vec2 a, glm::vec2 b) const;
+
+    // Splitting priority from the cell's estimated variation
+    void setPriority(Cell& cell, float variation) const;
+};
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "AllocationTracker.hpp"
+#include "Profiler.hpp"
+
+#ifdef EFIELD_TRACK_ALLOCATIONS
+
+thread_local const char* currentProfileZone = nullptr;
+
+namespace {
+    const char* const noZone = "(no zone)";
+    const size_t siteCount = 512;   // Zones beyond this share the last slot
+
+    // Fixed table keyed by the zone name pointer, so counting never allocates
+    struct SiteSlot {
+        std::atomic<const char*> zone{nullptr};
+        std::atomic<uint64_t> frameAllocations{0}, frameBytes{0};
+        std::atomic<uint64_t> totalAllocations{0}, totalBytes{0};
+    };
+
+    SiteSlot sites[siteCount];
+    std::atomic<uint64_t> frameAllocations{0}, frameBytes{0};
+
+    // Written by endFrame only
+    AllocationTracker::Counts lastFrame;
+    AllocationTracker::Site lastFrameSites[siteCount];
+    size_t lastFrameSiteCount = 0;
+    uint64_t frames = 0;
+    uint64_t allocatingFrames = 0;
+
+    SiteSlot& siteFor(const char* zone) {
+        size_t hash = (reinterpret_cast<uintptr_t>(zone) >> 3) * 0x9E3779B97F4A7C15ull;
+        for (size_t probe = 0; probe < siteCount - 1; probe++) {
+            SiteSlot& slot = sites[(hash + probe) % (siteCount - 1)];
+            const char* current = slot.zone.load(std::memory_order_acquire);
+            if (current == zone) return slot;
+            if (!current && slot.zone.compare_exchange_strong(current, zone, std::memory_order_acq_rel)) {
+                return slot;
+            }
+            if (current == zone) return slot;
+        }
+        // Table full: the last slot collects the rest
+        SiteSlot& overflow = sites[siteCount - 1];
+        const char* expected = nullptr;
+        overflow.zone.compare_exchange_strong(expected, "(other zones)", std::memory_order_acq_rel);
+        return overflow;
+    }
+
+    void countAllocation(size_t size) {
+        frameAllocations.fetch_add(1, std::memory_order_relaxed);
+        frameBytes.fetch_add(size, std::memory_order_relaxed);
+
+        SiteSlot& slot = siteFor(currentProfileZone ? currentProfileZone : noZone);
+        slot.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+        slot.frameBytes.fetch_add(size, std::memory_order_relaxed);
+        slot.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        slot.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void* allocate(size_t size) {
+        countAllocation(size);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocateAligned(size_t size, std::align_val_t alignment) {
+        countAllocation(size);
+        size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+        return _aligned_malloc(size ? size : 1, align);
+#else
+        // aligned_alloc wants a multiple of the alignment
+        size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;
+        return std::aligned_alloc(align, rounded);
+#endif
+    }
+
+    void releaseAligned(void* pointer) {
+#ifdef _WIN32
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+// Replacements of the global allocation functions; the sized and nothrow
+// forms forward to these
+void* operator new(size_t size) {
+    void* pointer = allocate(size);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+void* operator new[](size_t size) {
+    void* pointer = allocate(size);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* pointer = allocateAligned(size, alignment);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    void* pointer = allocateAligned(size, alignment);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(pointer); }
+
+bool AllocationTracker::enabled() {
+    return true;
+}
+
+void AllocationTracker::endFrame() {
+    lastFrame.allocations = frameAllocations.exchange(0, std::memory_order_relaxed);
+    lastFrame.bytes = frameBytes.exchange(0, std::memory_order_relaxed);
+
+    lastFrameSiteCount = 0;
+    for (SiteSlot& slot : sites) {
+        const char* zone = slot.zone.load(std::memory_order_acquire);
+        if (!zone) continue;
+        Counts counts;
+        counts.allocations = slot.frameAllocations.exchange(0, std::memory_order_relaxed);
+        counts.bytes = slot.frameBytes.exchange(0, std::memory_order_relaxed);
+        if (counts.allocations > 0) lastFrameSites[lastFrameSiteCount++] = Site{zone, counts};
+    }
+    std::sort(lastFrameSites, lastFrameSites + lastFrameSiteCount, [](const Site& a, const Site& b) {
+        return a.counts.allocations > b.counts.allocations;
+    });
+
+    frames++;
+    if (lastFrame.allocations > 0) allocatingFrames++;
+}
+
+AllocationTracker::Counts AllocationTracker::getLastFrame() {
+    return lastFrame;
+}
+
+size_t AllocationTracker::getLastFrameSites(Site* out, size_t capacity) {
+    size_t count = std::min(capacity, lastFrameSiteCount);
+    std::copy(lastFrameSites, lastFrameSites + count, out);
+    return count;
+}
+
+uint64_t AllocationTracker::getFrameCount() {
+    return frames;
+}
+
+uint64_t AllocationTracker::getAllocatingFrameCount() {
+    return allocatingFrames;
+}
+
+void AllocationTracker::report(std::ostream& out) {
+    // Copy out first: printing may allocate
+    std::vector<Site> totals;
+    totals.reserve(siteCount);
+    for (SiteSlot& slot : sites) {
+        const char* zone = slot.zone.load(std::memory_order_acquire);
+        if (!zone) continue;
+        Counts counts;
+        counts.allocations = slot.totalAllocations.load(std::memory_order_relaxed);
+        counts.bytes = slot.totalBytes.load(std::memory_order_relaxed);
+        if (counts.allocations > 0) totals.push_back(Site{zone, counts});
+    }
+
+    // Zones with the same name from different files have their own slots
+    std::sort(totals.begin(), totals.end(), [](const Site& a, const Site& b) {
+        return std::strcmp(a.zone, b.zone) < 0;
+    });
+    std::vector<Site> merged;
+    for (const Site& site : totals) {
+        if (!merged.empty() && std::strcmp(merged.back().zone, site.zone) == 0) {
+            merged.back().counts.allocations += site.counts.allocations;
+            merged.back().counts.bytes += site.counts.bytes;
+        } else {
+            merged.push_back(site);
+        }
+    }
+    std::sort(merged.begin(), merged.end(), [](const Site& a, const Site& b) {
+        return a.counts.allocations > b.counts.allocations;
+    });
+
+    out << "Allocations: " << allocatingFrames << " of " << frames << " frames allocated" << std::endl;
+    for (const Site& site : merged) {
+        out << "  " << site.zone << ": " << site.counts.allocations << " allocations, "
+            << site.counts.bytes << " bytes";
+        if (frames > 0) out << " (" << static_cast<double>(site.counts.allocations) / frames << " per frame)";
+        out << std::endl;
+    }
+}
+
+void AllocationTracker::resetTotals() {
+    for (SiteSlot& slot : sites) {
+        slot.totalAllocations.store(0, std::memory_order_relaxed);
+        slot.totalBytes.store(0, std::memory_order_relaxed);
+    }
+    frames = 0;
+    allocatingFrames = 0;
+}
+
+#else
+
+bool AllocationTracker::enabled() { return false; }
+void AllocationTracker::endFrame() {}
+AllocationTracker::Counts AllocationTracker::getLastFrame() { return Counts(); }
+size_t AllocationTracker::getLastFrameSites(Site*, size_t) { return 0; }
+uint64_t AllocationTracker::getFrameCount() { return 0; }
+uint64_t AllocationTracker::getAllocatingFrameCount() { return 0; }
+void AllocationTracker::report(std::ostream& out) {
+    out << "Allocation tracking is off (build with EFIELD_TRACK_ALLOCATIONS)" << std::endl;
+}
+void AllocationTracker::resetTotals() {}
+
+#endif
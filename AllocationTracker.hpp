@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+// Counts heap allocations per frame and per profiling zone.
+// Only active in builds with EFIELD_TRACK_ALLOCATIONS (CMake option
+// EFIELD_TRACK_ALLOCATIONS): the global operator new / delete are then
+// replaced with versions that count every allocation against the
+// innermost PROFILE_ZONE of the allocating thread (the "site"). Otherwise
+// nothing is replaced and every count stays zero.
+//
+// Counting is a few relaxed atomic adds per allocation and never
+// allocates itself, so it is safe from any thread.
+class AllocationTracker {
+public:
+    struct Counts {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Site {
+        const char* zone;   // "(no zone)" outside every PROFILE_ZONE
+        Counts counts;
+    };
+
+    // Whether this build counts allocations
+    static bool enabled();
+
+    // Closes the current frame: its counts become the "last frame" ones
+    static void endFrame();
+
+    // Allocations of the last closed frame, all threads
+    static Counts getLastFrame();
+
+    // Sites that allocated in the last closed frame, most allocations first;
+    // fills up to capacity entries of out and returns how many were written
+    static size_t getLastFrameSites(Site* out, size_t capacity);
+
+    // Frames closed so far, and how many of them allocated
+    static uint64_t getFrameCount();
+    static uint64_t getAllocatingFrameCount();
+
+    // Counts since the start (or the last resetTotals) per site
+    static void report(std::ostream& out);
+    static void resetTotals();
+};
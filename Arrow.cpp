@@ -1,12 +1,17 @@
+#include <algorithm>
+#include <cstddef>
+
 #include "Arrow.hpp"
 
-Arrow::Arrow() {
+Arrow::Arrow() : instanceCapacity(0) {
   setupArrow();
 }
 
 Arrow::~Arrow() {
   glDeleteVertexArrays(1,&VAO);
   glDeleteBuffers(1,&VBO);
+  glDeleteVertexArrays(1,&instancedVAO);
+  glDeleteBuffers(1,&instanceVBO);
 }
 
 void Arrow::setupArrow() {
@@ -35,9 +40,49 @@ void Arrow::setupArrow() {
 
   glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
   glEnableVertexAttribArray(0);
+
+  // Same shape plus the per-instance attributes: position and direction
+  // at location 1, scale and magnitude at location 2
+  glGenVertexArrays(1,&instancedVAO);
+  glGenBuffers(1,&instanceVBO);
+
+  glBindVertexArray(instancedVAO);
+
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
+  glEnableVertexAttribArray(0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  glVertexAttribPointer(1,4,GL_FLOAT,GL_FALSE,sizeof(ArrowInstance),(void*)offsetof(ArrowInstance, position));
+  glEnableVertexAttribArray(1);
+  glVertexAttribDivisor(1,1);
+  glVertexAttribPointer(2,2,GL_FLOAT,GL_FALSE,sizeof(ArrowInstance),(void*)offsetof(ArrowInstance, scale));
+  glEnableVertexAttribArray(2);
+  glVertexAttribDivisor(2,1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
 }
 
 void Arrow::draw() {
   glBindVertexArray(VAO);
   glDrawArrays(GL_TRIANGLES,0,9);
 }
+
+void Arrow::drawInstanced(const ArrowInstance* instances, size_t count) {
+  if (count == 0) return;
+
+  // Orphan the old storage (the GPU may still read it) and fill a fresh one;
+  // it only grows, doubling, so steady frames reuse the same size
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  if (count > instanceCapacity) {
+    instanceCapacity = std::max(count, 2 * instanceCapacity);
+  }
+  glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(ArrowInstance), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(ArrowInstance), instances);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindVertexArray(instancedVAO);
+  glDrawArraysInstanced(GL_TRIANGLES,0,9,static_cast<GLsizei>(count));
+  glBindVertexArray(0);
+}
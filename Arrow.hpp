@@ -1,5 +1,15 @@
 #pragma once
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Per-arrow data of the instanced path, laid out as the instance attributes
+struct ArrowInstance {
+  glm::vec2 position;
+  glm::vec2 direction;   // Unit vector the arrow points along
+  float scale;           // Length in world units
+  float magnitude;       // Colour ramp position, 0 (blue) to 1 (red)
+};
 
 class Arrow {
 public:
@@ -7,7 +17,15 @@ public:
   ~Arrow();
   void draw();
 
+  // Draws every instance with one call. The instances are streamed into a
+  // buffer that is orphaned each frame, so the driver never waits for the
+  // previous frame's draw; the vertex shader (shaders/arrow_vertex.glsl)
+  // rotates, scales and places the arrow.
+  void drawInstanced(const ArrowInstance* instances, size_t count);
+
 private:
   GLuint VAO, VBO;
+  GLuint instancedVAO, instanceVBO;
+  size_t instanceCapacity;   // Buffer size in instances
   void setupArrow();
 };
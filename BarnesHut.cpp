@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cmath>
+
+#include "BarnesHut.hpp"
+#include "ElectricField.hpp"
+
+namespace {
+    const int leafCapacity = 8;   // Charges per leaf before splitting
+    const int maxDepth = 32;      // Stops splitting coincident charges forever
+}
+
+void BarnesHutTree::build(const ChargeStorage& charges) {
+    nodes.clear();
+    sortedX.clear();
+    sortedY.clear();
+    sortedQ.clear();
+
+    size_t count = charges.size();
+    if (count == 0) return;
+
+    // Bounding square of all charges
+    float minX = charges.x[0], maxX = charges.x[0];
+    float minY = charges.y[0], maxY = charges.y[0];
+    for (size_t i = 1; i < count; i++) {
+        minX = std::min(minX, charges.x[i]);
+        maxX = std::max(maxX, charges.x[i]);
+        minY = std::min(minY, charges.y[i]);
+        maxY = std::max(maxY, charges.y[i]);
+    }
+    glm::vec2 center((minX + maxX) * 0.5f, (minY + maxY) * 0.5f);
+    float halfSize = std::max(maxX - minX, maxY - minY) * 0.5f + 1e-5f;
+
+    sortedX = charges.x;
+    sortedY = charges.y;
+    sortedQ = charges.q;
+
+    nodes.reserve(2 * count / leafCapacity + 1);
+    nodes.resize(1);
+    buildNode(0, center, halfSize, 0, static_cast<int>(count), 0);
+}
+
+void BarnesHutTree::buildNode(int index, glm::vec2 center, float halfSize, int begin, int end, int depth) {
+    // Expansion centre and monopole
+    float totalCharge = 0.0f;
+    float totalAbs = 0.0f;
+    glm::vec2 weighted(0.0f);
+    for (int i = begin; i < end; i++) {
+        float absQ = std::abs(sortedQ[i]);
+        totalCharge += sortedQ[i];
+        totalAbs += absQ;
+        weighted += absQ * glm::vec2(sortedX[i], sortedY[i]);
+    }
+    glm::vec2 expansion = totalAbs > 0.0f ? weighted / totalAbs : center;
+
+    // Dipole moment about the expansion centre
+    glm::vec2 dipole(0.0f);
+    for (int i = begin; i < end; i++) {
+        dipole += sortedQ[i] * (glm::vec2(sortedX[i], sortedY[i]) - expansion);
+    }
+
+    nodes[index] = Node{center, halfSize, expansion, totalCharge, dipole, -1, begin, end};
+
+    if (end - begin <= leafCapacity || depth >= maxDepth) return;
+
+    // Counting sort of the range into the quadrants (-,-) (+,-) (-,+) (+,+)
+    int count = end - begin;
+    std::vector<unsigned char> quadrant(count);
+    int bounds[5] = {0, 0, 0, 0, 0};
+    for (int k = 0; k < count; k++) {
+        int i = begin + k;
+        quadrant[k] = (sortedX[i] >= center.x ? 1 : 0) + (sortedY[i] >= center.y ? 2 : 0);
+        bounds[quadrant[k] + 1]++;
+    }
+    for (int quad = 0; quad < 4; quad++) bounds[quad + 1] += bounds[quad];
+
+    std::vector<float> tmpX(count), tmpY(count), tmpQ(count);
+    int cursor[4] = {bounds[0], bounds[1], bounds[2], bounds[3]};
+    for (int k = 0; k < count; k++) {
+        int slot = cursor[quadrant[k]]++;
+        tmpX[slot] = sortedX[begin + k];
+        tmpY[slot] = sortedY[begin + k];
+        tmpQ[slot] = sortedQ[begin + k];
+    }
+    std::copy(tmpX.begin(), tmpX.end(), sortedX.begin() + begin);
+    std::copy(tmpY.begin(), tmpY.end(), sortedY.begin() + begin);
+    std::copy(tmpQ.begin(), tmpQ.end(), sortedQ.begin() + begin);
+
+    // Children are stored next to each other so a node only needs one index
+    int firstChild = static_cast<int>(nodes.size());
+    nodes.resize(nodes.size() + 4);
+    nodes[index].firstChild = firstChild;
+
+    float childHalf = halfSize * 0.5f;
+    for (int quad = 0; quad < 4; quad++) {
+        glm::vec2 childCenter(center.x + ((quad & 1) ? childHalf : -childHalf),
+                              center.y + ((quad & 2) ? childHalf : -childHalf));
+        buildNode(firstChild + quad, childCenter, childHalf,
+                  begin + bounds[quad], begin + bounds[quad + 1], depth + 1);
+    }
+}
+
+template <typename FarFn, typename LeafFn>
+void BarnesHutTree::traverse(float x, float y, float theta, float cutoff2, FarFn far, LeafFn leaf) const {
+    if (nodes.empty()) return;
+
+    glm::vec2 point(x, y);
+    float theta2 = theta * theta;
+
+    int stack[4 * maxDepth + 4];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.begin == node.end) continue;
+
+        glm::vec2 r = point - node.expansion;
+        float distSquared = glm::dot(r, r);
+        float size = 2.0f * node.halfSize;
+
+        // Distance from the point to the cell; cells that reach into the
+        // cutoff disc are opened so the skipped charges match the direct sum
+        float gapX = std::max(std::abs(x - node.center.x) - node.halfSize, 0.0f);
+        float gapY = std::max(std::abs(y - node.center.y) - node.halfSize, 0.0f);
+        bool clearOfCutoff = gapX*gapX + gapY*gapY >= cutoff2;
+
+        if (node.firstChild >= 0 && clearOfCutoff && size * size < theta2 * distSquared) {
+            far(node, r, distSquared);
+        } else if (node.firstChild >= 0) {
+            for (int c = 0; c < 4; c++) stack[top++] = node.firstChild + c;
+        } else {
+            for (int i = node.begin; i < node.end; i++) leaf(i);
+        }
+    }
+}
+
+glm::vec2 BarnesHutTree::fieldAt(float x, float y, float theta, float cutoff2) const {
+    glm::vec2 total(0.0f);
+
+    traverse(x, y, theta, cutoff2,
+        [&](const Node& node, glm::vec2 r, float distSquared) {
+            // Far enough: monopole + dipole
+            float invDist = 1.0f / std::sqrt(distSquared);
+            float invDist3 = invDist * invDist * invDist;
+            float pr = glm::dot(node.dipole, r);
+            total += (node.charge * invDist3) * r
+                   + (3.0f * pr * invDist3 * invDist * invDist) * r
+                   - invDist3 * node.dipole;
+        },
+        [&](int i) {
+            // Leaf: direct sum over its charges
+            float rx = x - sortedX[i];
+            float ry = y - sortedY[i];
+            float d2 = rx*rx + ry*ry;
+            if (d2 < cutoff2) return;
+            float invDist = 1.0f / std::sqrt(d2);
+            float scale = sortedQ[i] * invDist * invDist * invDist;
+            total.x += scale * rx;
+            total.y += scale * ry;
+        });
+
+    return total;
+}
+
+float BarnesHutTree::potentialAt(float x, float y, float theta, float cutoff2) const {
+    float total = 0.0f;
+
+    traverse(x, y, theta, cutoff2,
+        [&](const Node& node, glm::vec2 r, float distSquared) {
+            // Q / d + p.r / d^3
+            float invDist = 1.0f / std::sqrt(distSquared);
+            total += node.charge * invDist + glm::dot(node.dipole, r) * invDist * invDist * invDist;
+        },
+        [&](int i) {
+            float rx = x - sortedX[i];
+            float ry = y - sortedY[i];
+            total += sortedQ[i] / std::sqrt(std::max(rx*rx + ry*ry, cutoff2));
+        });
+
+    return total;
+}
+
+glm::vec2 BarnesHutTree::softenedFieldAt(float x, float y, float theta, float softening2) const {
+    glm::vec2 total(0.0f);
+
+    traverse(x, y, theta, 0.0f,
+        [&](const Node& node, glm::vec2 r, float distSquared) {
+            float invDist = 1.0f / std::sqrt(distSquared);
+            float invDist3 = invDist * invDist * invDist;
+            float pr = glm::dot(node.dipole, r);
+            total += (node.charge * invDist3) * r
+                   + (3.0f * pr * invDist3 * invDist * invDist) * r
+                   - invDist3 * node.dipole;
+        },
+        [&](int i) {
+            float rx = x - sortedX[i];
+            float ry = y - sortedY[i];
+            float d2 = rx*rx + ry*ry;
+            if (d2 == 0.0f) return;
+            float invDist = 1.0f / std::sqrt(d2 + softening2);
+            float scale = sortedQ[i] * invDist * invDist * invDist;
+            total.x += scale * rx;
+            total.y += scale * ry;
+        });
+
+    return total;
+}
+
+void BarnesHutTree::fieldAtBatch(const float* xs, const float* ys, size_t n,
+                                 float* ex, float* ey, float theta, float cutoff2) const {
+    for (size_t i = 0; i < n; i++) {
+        glm::vec2 field = fieldAt(xs[i], ys[i], theta, cutoff2);
+        ex[i] = field.x;
+        ey[i] = field.y;
+    }
+}
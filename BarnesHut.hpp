@@ -0,0 +1,57 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+struct ChargeStorage;
+
+// Barnes–Hut quadtree over a set of point charges.
+// Far away cells are replaced by a monopole + dipole expansion about their
+// |q|-weighted centre, so mixed-sign clusters (dipoles, lattices) are still
+// approximated well. A cell is accepted when size / distance < theta: lower
+// theta is more accurate, higher theta is faster (theta = 0 is a direct sum).
+class BarnesHutTree {
+public:
+    // Rebuilds the tree from scratch for the given charges
+    void build(const ChargeStorage& charges);
+
+    // Field at a single point, skipping charges closer than sqrt(cutoff2)
+    glm::vec2 fieldAt(float x, float y, float theta, float cutoff2) const;
+
+    // Potential at a single point; distances below sqrt(cutoff2) are clamped
+    float potentialAt(float x, float y, float theta, float cutoff2) const;
+
+    // Field at a charge position for the dynamics: leaf charges are
+    // Plummer-softened and a charge at exactly (x, y) (the charge itself)
+    // is skipped; accepted cells use the plain expansion
+    glm::vec2 softenedFieldAt(float x, float y, float theta, float softening2) const;
+
+    // Field at n points, written to ex/ey
+    void fieldAtBatch(const float* xs, const float* ys, size_t n,
+                      float* ex, float* ey, float theta, float cutoff2) const;
+
+    bool empty() const { return nodes.empty(); }
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Node {
+        glm::vec2 center;      // Centre of the square cell
+        float halfSize;        // Half the side of the cell
+        glm::vec2 expansion;   // |q|-weighted centre used for the expansion
+        float charge;          // Total charge (monopole)
+        glm::vec2 dipole;      // Dipole moment about the expansion centre
+        int firstChild;        // Index of the first of 4 children, -1 for leaves
+        int begin, end;        // Range of sorted charges owned by this cell
+    };
+
+    std::vector<Node> nodes;
+
+    // Charges reordered so every cell owns a contiguous range
+    std::vector<float> sortedX, sortedY, sortedQ;
+
+    // Walks the tree for one point: far(node, r, distSquared) for accepted
+    // cells, leaf(i) for every charge of the leaves that had to be opened
+    template <typename FarFn, typename LeafFn>
+    void traverse(float x, float y, float theta, float cutoff2, FarFn far, LeafFn leaf) const;
+
+    void buildNode(int index, glm::vec2 center, float halfSize, int begin, int end, int depth);
+};
@@ -0,0 +1,60 @@
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+#include "Camera.hpp"
+
+void Camera::setViewport(int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    viewportWidth = width;
+    viewportHeight = height;
+}
+
+void Camera::setZoom(float newZoom) {
+    zoom = std::min(std::max(newZoom, minZoom), maxZoom);
+}
+
+void Camera::zoomAt(glm::vec2 screenPoint, float factor) {
+    glm::vec2 anchor = screenToWorld(screenPoint);
+    setZoom(zoom * factor);
+    center += anchor - screenToWorld(screenPoint);
+}
+
+void Camera::reset() {
+    center = glm::vec2(0.0f);
+    zoom = 1.0f;
+}
+
+glm::vec2 Camera::getHalfExtent() const {
+    // The shorter side spans 2 units at zoom 1, as the fixed view did
+    float aspectRatio = static_cast<float>(viewportWidth) / viewportHeight;
+    glm::vec2 half = aspectRatio >= 1.0f ? glm::vec2(aspectRatio, 1.0f) : glm::vec2(1.0f, 1.0f / aspectRatio);
+    return half / zoom;
+}
+
+glm::vec2 Camera::screenToWorld(glm::vec2 screen) const {
+    glm::vec2 normalized(2.0f * screen.x / viewportWidth - 1.0f, 2.0f * screen.y / viewportHeight - 1.0f);
+    return center + normalized * getHalfExtent();
+}
+
+glm::vec2 Camera::worldToScreen(glm::vec2 world) const {
+    glm::vec2 normalized = (world - center) / getHalfExtent();
+    return glm::vec2((normalized.x + 1.0f) * 0.5f * viewportWidth, (normalized.y + 1.0f) * 0.5f * viewportHeight);
+}
+
+glm::vec2 Camera::cursorToWorld(double xpos, double ypos) const {
+    return screenToWorld(glm::vec2(static_cast<float>(xpos), static_cast<float>(viewportHeight - ypos)));
+}
+
+float Camera::getWorldPerPixel() const {
+    return 2.0f * getHalfExtent().y / viewportHeight;
+}
+
+WorldRect Camera::getVisibleRect() const {
+    glm::vec2 half = getHalfExtent();
+    return WorldRect{center.x - half.x, center.x + half.x, center.y - half.y, center.y + half.y};
+}
+
+glm::mat4 Camera::getProjection() const {
+    WorldRect rect = getVisibleRect();
+    return glm::ortho(rect.xMin, rect.xMax, rect.yMin, rect.yMax);
+}
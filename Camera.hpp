@@ -0,0 +1,65 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Axis-aligned rectangle in world units
+struct WorldRect {
+    float xMin, xMax, yMin, yMax;
+
+    // Whether a disc of the given radius around point overlaps the rectangle
+    bool overlaps(glm::vec2 point, float radius = 0.0f) const {
+        return point.x + radius >= xMin && point.x - radius <= xMax
+            && point.y + radius >= yMin && point.y - radius <= yMax;
+    }
+};
+
+// 2D camera: a centre and a zoom over the original fixed view, where the
+// shorter window side spans 2 world units at zoom 1. The single place that
+// maps between the world and the window, so the projection, the mouse and
+// the text labels always agree.
+// Screen coordinates are window pixels from the bottom-left corner (the
+// text renderer's convention); cursor positions from GLFW go through
+// cursorToWorld, which flips y.
+class Camera {
+public:
+    // Window size in screen pixels; zero sizes (minimised) are ignored
+    void setViewport(int width, int height);
+    int getViewportWidth() const { return viewportWidth; }
+    int getViewportHeight() const { return viewportHeight; }
+
+    void setCenter(glm::vec2 newCenter) { center = newCenter; }
+    glm::vec2 getCenter() const { return center; }
+
+    // Clamped to [minZoom, maxZoom]
+    void setZoom(float newZoom);
+    float getZoom() const { return zoom; }
+
+    // Zooms by factor keeping the world point under screenPoint fixed
+    void zoomAt(glm::vec2 screenPoint, float factor);
+
+    // Back to the original view
+    void reset();
+
+    glm::vec2 screenToWorld(glm::vec2 screen) const;
+    glm::vec2 worldToScreen(glm::vec2 world) const;
+    glm::vec2 cursorToWorld(double xpos, double ypos) const;
+
+    // World units per screen pixel
+    float getWorldPerPixel() const;
+
+    // Visible part of the world
+    WorldRect getVisibleRect() const;
+
+    glm::mat4 getProjection() const;
+
+    static constexpr float minZoom = 0.02f;
+    static constexpr float maxZoom = 200.0f;
+
+private:
+    int viewportWidth = 1280;
+    int viewportHeight = 720;
+    glm::vec2 center = glm::vec2(0.0f);
+    float zoom = 1.0f;
+
+    // Half extent of the view in world units
+    glm::vec2 getHalfExtent() const;
+};
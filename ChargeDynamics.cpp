@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ChargeDynamics.hpp"
+#include "FieldKernels.hpp"
+#include "TaskScheduler.hpp"
+
+namespace {
+    const size_t chunkSize = 256;   // Charges per task for the force pass
+}
+
+ChargeDynamics::ChargeDynamics(float timeStep) : timeStep(std::max(timeStep, 1e-6f)) {}
+
+void ChargeDynamics::setTimeStep(float seconds) {
+    timeStep = std::max(seconds, 1e-6f);
+}
+
+void ChargeDynamics::setSoftening(float length) {
+    softening2 = length * length;
+    accelerationsValid = false;
+}
+
+void ChargeDynamics::reset() {
+    accumulator = 0.0;
+    accelerationsValid = false;
+}
+
+void ChargeDynamics::computeAccelerations() {
+    size_t n = state.size();
+    ax.resize(n);
+    ay.resize(n);
+
+    if (forceEngine == ForceEngine::BarnesHut) {
+        tree.build(state);
+    }
+
+    TaskScheduler::global().parallelFor(0, n, chunkSize, [&](size_t begin, size_t end) {
+        if (forceEngine == ForceEngine::BarnesHut) {
+            for (size_t i = begin; i < end; i++) {
+                glm::vec2 e = tree.softenedFieldAt(state.x[i], state.y[i], openingAngle, softening2);
+                ax[i] = e.x;
+                ay[i] = e.y;
+            }
+        } else {
+            computeSoftenedFieldBatch(state.x.data(), state.y.data(), state.q.data(), n,
+                                      state.x.data() + begin, state.y.data() + begin, end - begin,
+                                      ax.data() + begin, ay.data() + begin, softening2);
+        }
+        if (sources && !sources->empty()) {
+            sources->addFieldBatch(state.x.data() + begin, state.y.data() + begin, end - begin,
+                                   ax.data() + begin, ay.data() + begin);
+        }
+
+        // a = q E / m
+        for (size_t i = begin; i < end; i++) {
+            float scale = state.q[i] * inverseMass[i];
+            ax[i] *= scale;
+            ay[i] *= scale;
+        }
+    });
+}
+
+int ChargeDynamics::advance(ElectricField& field, double frameTime) {
+    const std::vector<ElectricCharge>& charges = field.getCharges();
+    size_t n = charges.size();
+    if (n == 0) {
+        accumulator = 0.0;
+        return 0;
+    }
+
+    accumulator += frameTime;
+    if (accumulator < timeStep) return 0;
+
+    sources = &field.getSources();
+
+    // Reload the state if anything but us touched the charges
+    if (!accelerationsValid || accelerationRevision != field.getRevision() || state.size() != n) {
+        state = field.getChargeStorage();
+        accelerationsValid = false;
+    }
+    vx.resize(n);
+    vy.resize(n);
+    inverseMass.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        bool fixed = static_cast<int>(i) == pinnedCharge || !(charges[i].mass > 0.0f);
+        float newInverseMass = fixed ? 0.0f : 1.0f / charges[i].mass;
+        // A mass changed from outside scales the cached accelerations
+        if (newInverseMass != inverseMass[i]) accelerationsValid = false;
+        inverseMass[i] = newInverseMass;
+        vx[i] = fixed ? 0.0f : charges[i].velocity.x;
+        vy[i] = fixed ? 0.0f : charges[i].velocity.y;
+    }
+
+    if (!accelerationsValid) computeAccelerations();
+
+    int steps = 0;
+    const float dt = timeStep;
+    const float halfDt = 0.5f * timeStep;
+    while (accumulator >= timeStep && steps < maxStepsPerFrame) {
+        // Kick, drift, recompute the forces, kick
+        for (size_t i = 0; i < n; i++) {
+            vx[i] += halfDt * ax[i];
+            vy[i] += halfDt * ay[i];
+            state.x[i] += dt * vx[i];
+            state.y[i] += dt * vy[i];
+        }
+        computeAccelerations();
+        for (size_t i = 0; i < n; i++) {
+            vx[i] += halfDt * ax[i];
+            vy[i] += halfDt * ay[i];
+        }
+
+        accumulator -= timeStep;
+        steps++;
+    }
+    if (steps == maxStepsPerFrame) accumulator = std::fmod(accumulator, static_cast<double>(timeStep));
+
+    field.setPositions(state.x.data(), state.y.data());
+    field.setVelocities(vx.data(), vy.data());
+
+    accelerationsValid = true;
+    accelerationRevision = field.getRevision();
+    return steps;
+}
+
+double ChargeDynamics::getEnergy(const ElectricField& field) const {
+    const std::vector<ElectricCharge>& charges = field.getCharges();
+    const ContinuousSources& fixedSources = field.getSources();
+
+    double energy = 0.0;
+    for (size_t i = 0; i < charges.size(); i++) {
+        glm::vec2 v = charges[i].velocity;
+        energy += 0.5 * charges[i].mass * (v.x * v.x + v.y * v.y);
+        if (!fixedSources.empty()) {
+            energy += charges[i].charge * fixedSources.potentialAt(charges[i].position.x, charges[i].position.y);
+        }
+
+        for (size_t j = i + 1; j < charges.size(); j++) {
+            glm::vec2 r = charges[i].position - charges[j].position;
+            double d2 = static_cast<double>(glm::dot(r, r)) + softening2;
+            energy += charges[i].charge * charges[j].charge / std::sqrt(d2);
+        }
+    }
+    return energy;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ElectricField.hpp"
+
+// Force evaluation used for each integration step
+enum class ForceEngine {
+    Direct,     // Every pair, O(N^2) per step (split across the task scheduler)
+    BarnesHut   // Quadtree rebuilt every step, O(N log N)
+};
+
+// Moves the charges of an ElectricField under their mutual Coulomb forces.
+// Velocity Verlet (kick-drift-kick) is symplectic, so energy does not
+// drift over long runs the way it does with explicit Euler. The step is
+// fixed and decoupled from the frame rate: each frame adds its duration
+// to an accumulator and as many whole steps as fit are taken. Forces are
+// Plummer-softened (|r|^2 + softening^2) so close passes stay bounded.
+// The field's continuous sources stay put and push the charges too.
+class ChargeDynamics {
+public:
+    explicit ChargeDynamics(float timeStep = 1.0f / 600.0f);
+
+    void setTimeStep(float seconds);
+    float getTimeStep() const { return timeStep; }
+
+    // Softening length; 0 is the plain Coulomb force
+    void setSoftening(float length);
+
+    void setForceEngine(ForceEngine engine) { forceEngine = engine; }
+    ForceEngine getForceEngine() const { return forceEngine; }
+
+    // Opening angle of the Barnes-Hut force engine
+    void setOpeningAngle(float theta) { openingAngle = theta > 0.0f ? theta : 0.0f; }
+
+    // Steps per frame at most; time beyond that is dropped so a slow frame
+    // does not snowball into ever more steps
+    void setMaxStepsPerFrame(int steps) { maxStepsPerFrame = steps > 0 ? steps : 1; }
+
+    // Charge held in place (the one being dragged), -1 for none
+    void setPinnedCharge(int index) {
+        if (index != pinnedCharge) accelerationsValid = false;
+        pinnedCharge = index;
+    }
+
+    // Advances the charges by frameTime seconds of simulated time and
+    // writes the new positions and velocities back. Returns the steps taken.
+    int advance(ElectricField& field, double frameTime);
+
+    // Drops the accumulated time and the cached forces
+    void reset();
+
+    // Kinetic + potential energy of the charges (softened), for checking
+    // the integrator
+    double getEnergy(const ElectricField& field) const;
+
+private:
+    float timeStep;
+    float softening2 = 0.05f * 0.05f;
+    ForceEngine forceEngine = ForceEngine::Direct;
+    float openingAngle = 0.5f;
+    int maxStepsPerFrame = 20;
+    int pinnedCharge = -1;
+
+    double accumulator = 0.0;
+
+    // Working state, structure-of-arrays
+    ChargeStorage state;
+    std::vector<float> vx, vy, inverseMass;
+    std::vector<float> ax, ay;
+    BarnesHutTree tree;
+    const ContinuousSources* sources = nullptr;   // The field's, set by advance
+
+    // The accelerations in ax/ay belong to this field revision
+    bool accelerationsValid = false;
+    uint64_t accelerationRevision = 0;
+
+    void computeAccelerations();
+};
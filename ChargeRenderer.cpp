@@ -1,16 +1,28 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <vector>
-#include <string>
-#include <iomanip>
 
 #include "ChargeRenderer.hpp"
 #include "TextRender.hpp"
+#include "Profiler.hpp"
+#include "FrameArena.hpp"
 
-ChargeRenderer::ChargeRenderer(TextRender* textRenderer, GLFWwindow* window, int segments)
- : textRenderer(textRenderer), window(window) {
+namespace {
+    const float labelCellPixels = 16.0f;    // Granularity of the overlap test
+    const float minLabelRadiusPixels = 8.0f;  // Smaller discs get no label
+
+    // Disc radius in world units for a charge
+    float chargeRadius(float charge) {
+        return 0.05f + 0.03f * std::abs(charge);
+    }
+}
+
+ChargeRenderer::ChargeRenderer(TextRender* textRenderer, const Camera* camera, int segments)
+ : textRenderer(textRenderer), camera(camera), instanceCapacity(0), labelsDrawn(0) {
     setupCircle(segments);
 }
 
@@ -18,6 +30,7 @@ ChargeRenderer::~ChargeRenderer() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &instanceVBO);
 }
 
 void ChargeRenderer::setupCircle(int segments) {
@@ -65,6 +78,13 @@ void ChargeRenderer::setupCircle(int segments) {
     // Set vertex attributes
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+
+    // Per-instance centre, radius and charge, streamed each frame
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
     
     // Unbind
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -72,79 +92,98 @@ void ChargeRenderer::setupCircle(int segments) {
 }
 
 void ChargeRenderer::draw(const std::vector<ElectricCharge>& charges, GLuint shaderProgram) {
-    //
+    PROFILE_ZONE("ChargeRenderer::draw");
     GLint originalProgram;
     glGetIntegerv(GL_CURRENT_PROGRAM, &originalProgram);
     
     // Make sure we're using the charge shader program
     glUseProgram(shaderProgram);
 
-
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLint chargeLoc = glGetUniformLocation(shaderProgram, "charge");
-    
-    glBindVertexArray(VAO);
-    
+    // Charges off screen cost neither an instance nor a label
+    WorldRect visible = camera->getVisibleRect();
+    FrameVector<glm::vec4> instances{ArenaAllocator<glm::vec4>(FrameArena::frame())};
+    instances.reserve(charges.size());
     for (const auto& charge : charges) {
-        // Set the charge value for coloring
-        glUniform1f(chargeLoc, charge.charge);
+        float radius = chargeRadius(charge.charge);
+        if (!visible.overlaps(charge.position, radius)) continue;
+        instances.emplace_back(charge.position.x, charge.position.y, radius, charge.charge);
+    }
 
-        // Create model matrix for position and size
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(charge.position.x, charge.position.y, 0.0f));
-        
-        // Size based on charge magnitude (with a minimum size and some scaling)
-        float size = 0.05f + 0.03f * std::abs(charge.charge);
-        model = glm::scale(model, glm::vec3(size, size, 1.0f));
-        
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        
-        // Draw the circle
-        glDrawElements(GL_TRIANGLES, vertexCount, GL_UNSIGNED_INT, 0);
+    if (!instances.empty()) {
+        // Orphan and refill, as for the arrows
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (instances.size() > instanceCapacity) {
+            instanceCapacity = std::max(instances.size(), 2 * instanceCapacity);
+        }
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::vec4), instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, vertexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(instances.size()));
+        glBindVertexArray(0);
     }
-        /* ---- Carge value rendering ---- */
 
-    for (const auto& charge : charges) {
-        // Text colour
-        glm::vec3 color(1.0f, 1.0f, 1.0f);
-            
-        // Size based on charge magnitude (with a minimum size and some scaling)
-        float size = 0.05f + 0.03f * std::abs(charge.charge);
-            
-        // Get window dimensions
-        int windowWidth, windowHeight;
-        glfwGetWindowSize(window, &windowWidth, &windowHeight);
-            
-        // Get viewport aspect ratio for proper scaling
-        float aspectRatio = (float)windowWidth / (float)windowHeight;
-            
-        // Convert from world to screen coordinates with aspect ratio correction
-        float screenX, screenY;
-            
-        if (aspectRatio >= 1.0f) {
-            // Wider window
-            screenX = (charge.position.x / aspectRatio + 1.0f) * 0.5f * windowWidth;
-            screenY = (charge.position.y + 1.0f) * 0.5f * windowHeight;
-        } else {
-            // Taller window
-            screenX = (charge.position.x + 1.0f) * 0.5f * windowWidth;
-            screenY = (charge.position.y * aspectRatio + 1.0f) * 0.5f * windowHeight;
+    drawLabels(charges);
+    glUseProgram(originalProgram);
+}
+
+void ChargeRenderer::drawLabels(const std::vector<ElectricCharge>& charges) {
+    PROFILE_ZONE("Charge labels");
+    labelsDrawn = 0;
+    if (labels.size() != charges.size()) {
+        // NaN never equals a charge, so every entry gets formatted on use
+        labels.resize(charges.size());
+        for (Label& label : labels) label.charge = std::nanf("");
+    }
+
+    int width = camera->getViewportWidth();
+    int height = camera->getViewportHeight();
+    size_t cellColumns = static_cast<size_t>(std::ceil(width / labelCellPixels));
+    size_t cellRows = static_cast<size_t>(std::ceil(height / labelCellPixels));
+    occupied.assign(cellColumns * cellRows, 0);
+
+    // Disc radius in pixels per world unit
+    float pixelsPerWorld = 1.0f / camera->getWorldPerPixel();
+    glm::vec3 color(1.0f, 1.0f, 1.0f);
+
+    for (size_t i = 0; i < charges.size(); i++) {
+        const ElectricCharge& charge = charges[i];
+        float size = chargeRadius(charge.charge);
+        if (size * pixelsPerWorld < minLabelRadiusPixels) continue;
+
+        // Re-format only when the value changed
+        Label& label = labels[i];
+        if (label.charge != charge.charge) {
+            int length = std::snprintf(label.text, sizeof(label.text), "%.1fC", charge.charge);
+            label.length = static_cast<uint8_t>(std::min<int>(std::max(length, 0), sizeof(label.text) - 1));
+            label.charge = charge.charge;
+            // Adjust text size based on charge size but keep it readable
+            label.scale = std::max(0.4f, size * 10.0f);
+            label.extent = textRenderer->measureText(std::string_view(label.text, label.length), label.scale);
         }
-        
-        // Format charge value with 1 decimal place
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(1) << charge.charge;
-        std::string chargeText = ss.str();
-        
-        // Adjust text size based on charge size but keep it readable
-        float textScale = std::max(0.4f, size * 10.0f);
-        
-        // Render the text centered on the charge
-        textRenderer->renderText(chargeText + "C", screenX - abs(charge.charge) * 10.0f - 20.0f, screenY - 7.5f, textScale, color);
+
+        // Text placed left of the charge's centre, as before
+        glm::vec2 screen = camera->worldToScreen(charge.position);
+        float x = screen.x - std::abs(charge.charge) * 10.0f - 20.0f;
+        float y = screen.y - 7.5f;
+        if (x + label.extent.x < 0.0f || x >= width || y + label.extent.y < 0.0f || y >= height) continue;
+
+        // Skip it if any cell it covers already holds a label
+        size_t c0 = static_cast<size_t>(std::max(0.0f, x / labelCellPixels));
+        size_t r0 = static_cast<size_t>(std::max(0.0f, y / labelCellPixels));
+        size_t c1 = std::min(cellColumns - 1, static_cast<size_t>((x + label.extent.x) / labelCellPixels));
+        size_t r1 = std::min(cellRows - 1, static_cast<size_t>((y + label.extent.y) / labelCellPixels));
+        bool free = true;
+        for (size_t r = r0; r <= r1 && free; r++) {
+            for (size_t c = c0; c <= c1 && free; c++) free = occupied[r * cellColumns + c] == 0;
+        }
+        if (!free) continue;
+        for (size_t r = r0; r <= r1; r++) {
+            for (size_t c = c0; c <= c1; c++) occupied[r * cellColumns + c] = 1;
         }
 
-    
-    glBindVertexArray(0);
-    glUseProgram(originalProgram);
-}
\ No newline at end of file
+        textRenderer->renderText(std::string_view(label.text, label.length), x, y, label.scale, color);
+        labelsDrawn++;
+    }
+}
@@ -1,21 +1,53 @@
 #pragma once
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 #include <GLFW/glfw3.h>
 
 #include "ElectricField.hpp"
+#include "TextRender.hpp"
+#include "Camera.hpp"
 
+// Draws the charges as discs, all of them with one instanced call, and
+// their values as labels.
+// Labels are formatted once per charge value and cached. A label is
+// skipped when it is off screen, when its disc is too small on screen to
+// carry one, or when it would overlap a label already placed this frame
+// (checked on a coarse grid of screen cells), so dense scenes stay
+// readable and cost a bounded number of text draws.
 class ChargeRenderer {
 public:
-    ChargeRenderer(TextRender* textRenderer, GLFWwindow* window, int segments = 32);
+    ChargeRenderer(TextRender* textRenderer, const Camera* camera, int segments = 32);
     ~ChargeRenderer();
     
+    // Draws the charges that overlap the camera's view, and their labels.
+    // The shader reads the per-instance attribute (shaders/charge_vertex.glsl).
     void draw(const std::vector<ElectricCharge>& charges, GLuint shaderProgram);
 
+    // Labels drawn by the last draw (for diagnostics)
+    size_t getLabelsDrawn() const { return labelsDrawn; }
+
 private:
+    struct Label {
+        float charge;            // Value the text was made for
+        char text[16];
+        uint8_t length;
+        float scale;
+        glm::vec2 extent;        // Size on screen in pixels
+    };
+
     TextRender* textRenderer;
-    GLFWwindow* window;
+    const Camera* camera;
     GLuint VAO, VBO, EBO;
+    GLuint instanceVBO;
+    size_t instanceCapacity;     // Buffer size in instances
     int vertexCount;
+
+    std::vector<Label> labels;   // One per charge, by index
+    std::vector<uint8_t> occupied;   // Screen cells covered by placed labels
+    size_t labelsDrawn;
+
     void setupCircle(int segments);
-};
\ No newline at end of file
+    void drawLabels(const std::vector<ElectricCharge>& charges);
+};
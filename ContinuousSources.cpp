@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ContinuousSources.hpp"
+#include "TaskScheduler.hpp"
+
+namespace {
+    const double pi = 3.14159265358979323846;
+    const double k = 1.0;                  // Same constant as the point charges
+    const double softening2 = 4e-4;        // (0.02)^2, keeps the field finite on a source
+    const size_t chunkSize = 1024;         // Points per task for large batches
+
+    // Carlson's symmetric elliptic integrals RF(x, y, z) and RD(x, y, z) =
+    // RJ(x, y, z, z) together: both use the same duplication steps
+    void carlsonRFRD(double x, double y, double z, double& rf, double& rd) {
+        const double tolerance = 2e-3;     // The series below are then good to ~1e-16
+        double sum = 0.0, factor = 1.0;
+        while (true) {
+            double sx = std::sqrt(x), sy = std::sqrt(y), sz = std::sqrt(z);
+            double lambda = sx * (sy + sz) + sy * sz;
+            sum += factor / (sz * (z + lambda));
+            factor *= 0.25;
+            x = 0.25 * (x + lambda);
+            y = 0.25 * (y + lambda);
+            z = 0.25 * (z + lambda);
+            double mean = 0.2 * (x + y + 3.0 * z);
+            double spread = std::max({std::abs(mean - x), std::abs(mean - y), std::abs(mean - z)});
+            if (spread < tolerance * mean) break;
+        }
+
+        double meanF = (x + y + z) / 3.0;
+        double fx = 1.0 - x / meanF, fy = 1.0 - y / meanF, fz = 1.0 - z / meanF;
+        double e2 = fx * fy - fz * fz;
+        double e3 = fx * fy * fz;
+        rf = (1.0 - e2 / 10.0 + e3 / 14.0 + e2 * e2 / 24.0 - 3.0 * e2 * e3 / 44.0) / std::sqrt(meanF);
+
+        double meanD = 0.2 * (x + y + 3.0 * z);
+        double dx = (meanD - x) / meanD, dy = (meanD - y) / meanD, dz = (meanD - z) / meanD;
+        double ea = dx * dy, eb = dz * dz;
+        double ec = ea - eb, ed = ea - 6.0 * eb, ee = ed + ec + ec;
+        const double c1 = 3.0 / 14.0, c2 = 1.0 / 6.0, c3 = 9.0 / 22.0, c4 = 3.0 / 26.0;
+        const double c5 = 0.25 * c3, c6 = 1.5 * c4;
+        rd = 3.0 * sum + factor * (1.0 + ed * (-c1 + c5 * ed - c6 * dz * ee)
+                                   + dz * (c2 * ee + dz * (-c3 * ec + dz * c4 * ea))) / (meanD * std::sqrt(meanD));
+    }
+
+    // Incomplete elliptic integrals of parameter m (< 1) at any amplitude:
+    // F = int dt / D, E = int D dt and J = int dt / D^3, D = sqrt(1 - m sin^2 t)
+    struct Elliptic {
+        double m, completeF, completeE;
+
+        explicit Elliptic(double m) : m(m) {
+            double rf, rd;
+            carlsonRFRD(0.0, 1.0 - m, 1.0, rf, rd);
+            completeF = rf;
+            completeE = rf - m / 3.0 * rd;
+        }
+
+        void at(double amplitude, double& f, double& e, double& j) const {
+            // Each half period adds a complete integral
+            double periods = std::floor(amplitude / pi + 0.5);
+            double phi = amplitude - periods * pi;
+            double s = std::sin(phi), c = std::cos(phi);
+            double delta2 = 1.0 - m * s * s;
+            double rf, rd;
+            carlsonRFRD(c * c, delta2, 1.0, rf, rd);
+            f = 2.0 * periods * completeF + s * rf;
+            e = 2.0 * periods * completeE + s * rf - m / 3.0 * s * s * s * rd;
+            j = (e - m * s * c / std::sqrt(delta2)) / (1.0 - m);
+        }
+    };
+
+    // Integrals over theta in [theta0, theta1] of 1/r, 1/r^3 and r, where
+    // r^2 = a - b cos(theta) (a > b >= 0). With theta = pi - 2 psi,
+    // r^2 = (a + b)(1 - m sin^2 psi), m = 2b / (a + b).
+    struct ArcIntegrals {
+        double inverse, inverseCube, distance;
+    };
+
+    ArcIntegrals arcIntegrals(double a, double b, double theta0, double theta1, const Elliptic& elliptic) {
+        double f0, e0, j0, f1, e1, j1;
+        elliptic.at(0.5 * (pi - theta0), f0, e0, j0);
+        elliptic.at(0.5 * (pi - theta1), f1, e1, j1);
+        double scale = std::sqrt(a + b);
+        ArcIntegrals result;
+        result.inverse = 2.0 * (f0 - f1) / scale;
+        result.inverseCube = 2.0 * (j0 - j1) / (scale * scale * scale);
+        result.distance = 2.0 * (e0 - e1) * scale;
+        return result;
+    }
+
+    void addLineTerms(const LineSource& line, double x, double y, bool withPotential,
+                 double& ex, double& ey, double& potential) {
+        double tx = line.end.x - line.start.x, ty = line.end.y - line.start.y;
+        double length = std::sqrt(tx * tx + ty * ty);
+        double px = x - line.start.x, py = y - line.start.y;
+
+        if (length < 1e-12) {
+            // Degenerate: a softened point charge
+            double r2 = px * px + py * py + softening2;
+            double inverse = 1.0 / std::sqrt(r2);
+            ex += k * line.charge * px * inverse * inverse * inverse;
+            ey += k * line.charge * py * inverse * inverse * inverse;
+            if (withPotential) potential += k * line.charge * inverse;
+            return;
+        }
+
+        tx /= length;
+        ty /= length;
+        double lambda = line.charge / length;
+        double along = px * tx + py * ty;           // From the start, along the segment
+        double across = -px * ty + py * tx;         // Signed distance from the line
+        double d2 = across * across + softening2;
+
+        double toStart = along, toEnd = along - length;
+        double rStart = std::sqrt(toStart * toStart + d2);
+        double rEnd = std::sqrt(toEnd * toEnd + d2);
+
+        // Along: k lambda (1/rEnd - 1/rStart), written without the cancellation
+        double fieldAlong = k * lambda * length * (2.0 * along - length) / (rStart * rEnd * (rStart + rEnd));
+
+        // Across: k lambda d / d2 (toStart/rStart - toEnd/rEnd); beyond either
+        // end the two terms nearly cancel, so use the rationalised form there
+        double fieldAcross;
+        if (toStart * toEnd > 0.0) {
+            fieldAcross = k * lambda * across * (toStart * toStart - toEnd * toEnd)
+                        / (rStart * rEnd * (toStart * rEnd + toEnd * rStart));
+        } else {
+            fieldAcross = k * lambda * across / d2 * (toStart / rStart - toEnd / rEnd);
+        }
+
+        ex += fieldAlong * tx - fieldAcross * ty;
+        ey += fieldAlong * ty + fieldAcross * tx;
+        if (withPotential) {
+            double d = std::sqrt(d2);
+            potential += k * lambda * (std::asinh(toStart / d) - std::asinh(toEnd / d));
+        }
+    }
+
+    void addArcTerms(const ArcSource& arc, double x, double y, bool withPotential,
+                double& ex, double& ey, double& potential) {
+        double radius = arc.radius;
+        double span = std::min<double>(arc.endAngle - arc.startAngle, 2.0 * pi);
+        if (radius <= 0.0 || span <= 0.0) return;
+        double lambda = arc.charge / (radius * span);
+
+        double px = x - arc.center.x, py = y - arc.center.y;
+        double rho = std::sqrt(px * px + py * py);
+        double a = rho * rho + radius * radius + softening2;
+        double b = 2.0 * rho * radius;
+
+        if (rho < 1e-6 * radius) {
+            // At the centre every element is at the same distance
+            double r2 = radius * radius + softening2;
+            double scale = k * lambda * radius * radius / (r2 * std::sqrt(r2));
+            ex -= scale * (std::sin(arc.startAngle + span) - std::sin(arc.startAngle));
+            ey -= scale * (std::cos(arc.startAngle) - std::cos(arc.startAngle + span));
+            if (withPotential) potential += k * lambda * radius * span / std::sqrt(r2);
+            return;
+        }
+
+        // Frame with the point on the +x axis
+        double ux = px / rho, uy = py / rho;
+        double alpha = std::atan2(py, px);
+        double theta0 = arc.startAngle - alpha;
+        double theta1 = theta0 + span;
+
+        Elliptic elliptic(2.0 * b / (a + b));
+        ArcIntegrals integrals = arcIntegrals(a, b, theta0, theta1, elliptic);
+
+        // Radial: int (rho - R cos) / r^3, with int cos / r^3 = (a I3 - I1) / b
+        double cosineCube = (a * integrals.inverseCube - integrals.inverse) / b;
+        double radial = k * lambda * radius * (rho * integrals.inverseCube - radius * cosineCube);
+
+        // Tangential: int -R sin / r^3 is exact, d(1/r)/dtheta = -b sin / (2 r^3)
+        double r0 = std::sqrt(a - b * std::cos(theta0));
+        double r1 = std::sqrt(a - b * std::cos(theta1));
+        double sineCube = 2.0 * (std::cos(theta0) - std::cos(theta1)) / (r0 * r1 * (r0 + r1));
+        double tangential = -k * lambda * radius * radius * sineCube;
+
+        ex += radial * ux - tangential * uy;
+        ey += radial * uy + tangential * ux;
+        if (withPotential) potential += k * lambda * radius * integrals.inverse;
+    }
+
+    void addDiskTerms(const DiskSource& disk, double x, double y, bool withPotential,
+                 double& ex, double& ey, double& potential) {
+        double radius = disk.radius;
+        if (radius <= 0.0) return;
+        double sigma = disk.charge / (pi * radius * radius);
+
+        double px = x - disk.center.x, py = y - disk.center.y;
+        double rho = std::sqrt(px * px + py * py);
+        double a = rho * rho + radius * radius + softening2;
+        double b = 2.0 * rho * radius;
+
+        // Whole circle: theta from -pi to pi is psi from pi to 0, two complete integrals
+        Elliptic elliptic(2.0 * b / (a + b));
+        double scale = std::sqrt(a + b);
+        double inverse = 4.0 * elliptic.completeF / scale;
+        double distance = 4.0 * elliptic.completeE * scale;
+
+        // E = k sigma * boundary integral of n / r; the tangential part cancels
+        if (rho > 1e-6 * radius) {
+            double cosine = (a * inverse - distance) / b;   // int cos / r
+            double radial = k * sigma * radius * cosine;
+            ex += radial * px / rho;
+            ey += radial * py / rho;
+        }
+        // V = k sigma * boundary integral of (s - p).n / r, (s - p).n = R - rho cos.
+        // With softening the exact potential also has -a * (angle subtended)
+        // + a^2 * boundary integral of (s - p).n / r^3, up to O(a^3). The angle
+        // (2 pi inside, 0 outside) is blended across the rim with the exact
+        // profile of a chord through the nearest rim point (see the polygon),
+        // less the chord's own share of those two terms
+        if (withPotential) {
+            double a0 = std::sqrt(softening2);
+            double inverseCube = 4.0 * elliptic.completeE / ((1.0 - elliptic.m) * scale * scale * scale);
+            double cosineCube = rho > 1e-6 * radius ? (a * inverseCube - inverse) / b : 0.0;
+            double flux = radius * (radius * inverseCube - rho * cosineCube);
+
+            double depth = radius - rho;
+            double rim = -pi * a0;
+            if (depth != 0.0) {
+                double chord = radius;
+                double r = std::sqrt(chord * chord + depth * depth + softening2);
+                double exact = 2.0 * a0 * std::atan(chord * depth * (a0 - r) / (depth * depth * r + a0 * chord * chord));
+                double sharp = 2.0 * std::atan(chord / depth);
+                double chordFlux = 2.0 * depth * chord / ((depth * depth + softening2) * r);
+                rim = -a0 * (depth > 0.0 ? 2.0 * pi : 0.0) + exact + a0 * sharp - softening2 * chordFlux;
+            }
+            potential += k * sigma * (0.5 * ((2.0 * radius * radius - a) * inverse + distance)
+                                      + softening2 * flux + rim);
+        }
+    }
+
+    void addPolygonTerms(const PolygonSource& polygon, double x, double y, bool withPotential,
+                    double& ex, double& ey, double& potential) {
+        size_t count = polygon.vertices.size();
+        if (count < 3) return;
+
+        double area = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            const glm::vec2& p = polygon.vertices[i];
+            const glm::vec2& q = polygon.vertices[(i + 1) % count];
+            area += 0.5 * (static_cast<double>(p.x) * q.y - static_cast<double>(q.x) * p.y);
+        }
+        if (std::abs(area) < 1e-12) return;
+        double sigma = polygon.charge / std::abs(area);
+        double winding = area > 0.0 ? 1.0 : -1.0;
+
+        // Per edge: int dl / r = asinh(u_end / d) - asinh(u_start / d). The
+        // field is exact; the potential is int dphi (sqrt(rho^2 + a^2) - a)
+        // around the point, which is elementary along a straight edge
+        double fieldX = 0.0, fieldY = 0.0, sum = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            const glm::vec2& p = polygon.vertices[i];
+            const glm::vec2& q = polygon.vertices[(i + 1) % count];
+            double tx = q.x - p.x, ty = q.y - p.y;
+            double length = std::sqrt(tx * tx + ty * ty);
+            if (length < 1e-12) continue;
+            tx /= length;
+            ty /= length;
+            double nx = winding * ty, ny = -winding * tx;   // Outward normal
+
+            double sx = p.x - x, sy = p.y - y;
+            double uStart = sx * tx + sy * ty;
+            double height = sx * nx + sy * ny;
+            double d = std::sqrt(height * height + softening2);
+            double uEnd = uStart + length;
+            double edge = std::asinh(uEnd / d) - std::asinh(uStart / d);
+
+            fieldX += nx * edge;
+            fieldY += ny * edge;
+            sum += height * edge;
+            if (withPotential) {
+                // Exact softened potential: the a * (angle subtended) term,
+                // written so it stays continuous as height goes to zero
+                double a0 = std::sqrt(softening2);
+                double rStart = std::sqrt(uStart * uStart + d * d);
+                double rEnd = std::sqrt(uEnd * uEnd + d * d);
+                sum += a0 * (std::atan2(uEnd * height * (a0 - rEnd), height * height * rEnd + a0 * uEnd * uEnd)
+                           - std::atan2(uStart * height * (a0 - rStart), height * height * rStart + a0 * uStart * uStart));
+            }
+        }
+
+        ex += k * sigma * fieldX;
+        ey += k * sigma * fieldY;
+        if (withPotential) potential += k * sigma * sum;
+    }
+}
+
+void ContinuousSources::addLine(const LineSource& line) {
+    lines.push_back(line);
+    version++;
+}
+
+void ContinuousSources::addArc(const ArcSource& arc) {
+    arcs.push_back(arc);
+    version++;
+}
+
+void ContinuousSources::addDisk(const DiskSource& disk) {
+    disks.push_back(disk);
+    version++;
+}
+
+void ContinuousSources::addPolygon(const PolygonSource& polygon) {
+    polygons.push_back(polygon);
+    version++;
+}
+
+void ContinuousSources::clear() {
+    lines.clear();
+    arcs.clear();
+    disks.clear();
+    polygons.clear();
+    version++;
+}
+
+void ContinuousSources::evaluate(double x, double y, bool withPotential,
+                                 double& ex, double& ey, double& potential) const {
+    ex = ey = potential = 0.0;
+    for (const LineSource& line : lines) addLineTerms(line, x, y, withPotential, ex, ey, potential);
+    for (const ArcSource& arc : arcs) addArcTerms(arc, x, y, withPotential, ex, ey, potential);
+    for (const DiskSource& disk : disks) addDiskTerms(disk, x, y, withPotential, ex, ey, potential);
+    for (const PolygonSource& polygon : polygons) addPolygonTerms(polygon, x, y, withPotential, ex, ey, potential);
+}
+
+glm::vec2 ContinuousSources::fieldAt(float x, float y) const {
+    double ex, ey, potential;
+    evaluate(x, y, false, ex, ey, potential);
+    return glm::vec2(static_cast<float>(ex), static_cast<float>(ey));
+}
+
+float ContinuousSources::potentialAt(float x, float y) const {
+    double ex, ey, potential;
+    evaluate(x, y, true, ex, ey, potential);
+    return static_cast<float>(potential);
+}
+
+void ContinuousSources::addFieldBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey) const {
+    if (empty()) return;
+    TaskScheduler::global().parallelFor(0, n, chunkSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double fx, fy, potential;
+            evaluate(xs[i], ys[i], false, fx, fy, potential);
+            ex[i] += static_cast<float>(fx);
+            ey[i] += static_cast<float>(fy);
+        }
+    });
+}
+
+void ContinuousSources::addPotentialBatch(const float* xs, const float* ys, size_t n, float* potential) const {
+    if (empty()) return;
+    TaskScheduler::global().parallelFor(0, n, chunkSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double fx, fy, value;
+            evaluate(xs[i], ys[i], true, fx, fy, value);
+            potential[i] += static_cast<float>(value);
+        }
+    });
+}
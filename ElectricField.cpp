@@ -1,6 +1,5 @@
-#include <GLFW/glfw3.h>
-
 #include "ElectricField.hpp"
+#include "FieldKernels.hpp"
 
 
 // Just for hpp file implementation
@@ -8,3 +7,93 @@
 
 // Update: Here will be the MW updates
 
+void ElectricField::getFieldAtBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey) const {
+    getChargeFieldAtBatch(xs, ys, n, ex, ey);
+    sources.addFieldBatch(xs, ys, n, ex, ey);
+}
+
+void ElectricField::getChargeFieldAtBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey) const {
+    const float epsilon = 0.01f; // Same cutoff as getFieldAt
+
+    if (engine == FieldEngine::BarnesHut) {
+        getTree().fieldAtBatch(xs, ys, n, ex, ey, openingAngle, epsilon);
+        return;
+    }
+    if (engine == FieldEngine::Multipole) {
+        multipole.evaluate(storage, xs, ys, n, ex, ey, epsilon);
+        return;
+    }
+
+    // The SIMD kernel already keeps up with the specialised ones on batches,
+    // so those are only used for the softening modes it does not have
+    if (softening != SofteningMode::HardCutoff) {
+        if (SmallFieldBatchKernel kernel = selectSmallFieldBatchKernel(storage.size(), softening)) {
+            kernel(storage.x.data(), storage.y.data(), storage.q.data(), xs, ys, n, ex, ey, epsilon);
+        } else {
+            computeFieldBatchWithMode(softening, storage.x.data(), storage.y.data(), storage.q.data(), storage.size(),
+                                      xs, ys, n, ex, ey, epsilon);
+        }
+        return;
+    }
+
+    computeFieldBatch(storage.x.data(), storage.y.data(), storage.q.data(), storage.size(),
+                      xs, ys, n, ex, ey, epsilon);
+}
+
+glm::vec2 ElectricField::getFieldAt(float x, float y, FieldPrecision precision) const {
+    glm::vec2 field;
+    getFieldAtBatch(&x, &y, 1, &field.x, &field.y, precision);
+    return field;
+}
+
+void ElectricField::getFieldAtBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey,
+                                    FieldPrecision precision) const {
+    if (precision == FieldPrecision::Float) {
+        getFieldAtBatch(xs, ys, n, ex, ey);
+        return;
+    }
+
+    const float epsilon = 0.01f; // Same cutoff as getFieldAt
+    computeFieldBatchPrecise(precision, softening, storage.x.data(), storage.y.data(), storage.q.data(),
+                             storage.size(), xs, ys, n, ex, ey, epsilon);
+    // Already summed in double
+    sources.addFieldBatch(xs, ys, n, ex, ey);
+}
+
+void ElectricField::getPotentialAtBatch(const float* xs, const float* ys, size_t n, float* potential) const {
+    const float epsilon = 0.01f; // Same clamp as getPotentialAt
+
+    if (engine != FieldEngine::Direct) {
+        const BarnesHutTree& potentialTree = getTree();
+        for (size_t i = 0; i < n; i++) {
+            potential[i] = potentialTree.potentialAt(xs[i], ys[i], openingAngle, epsilon);
+        }
+    } else {
+        computePotentialBatch(storage.x.data(), storage.y.data(), storage.q.data(), storage.size(),
+                              xs, ys, n, potential, epsilon);
+    }
+    sources.addPotentialBatch(xs, ys, n, potential);
+}
+
+const BarnesHutTree& ElectricField::getTree() const {
+    if (treeDirty.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(treeMutex);
+        if (treeDirty.load(std::memory_order_relaxed)) {
+            tree.build(storage);
+            treeDirty.store(false, std::memory_order_release);
+        }
+    }
+    return tree;
+}
+
+glm::vec2 ElectricField::getFieldAtTree(float x, float y) const {
+    const float epsilon = 0.01f; // Same cutoff as the direct sum
+
+    return getTree().fieldAt(x, y, openingAngle, epsilon);
+}
+
+float ElectricField::getPotentialAtTree(float x, float y) const {
+    const float epsilon = 0.01f;
+
+    return getTree().potentialAt(x, y, openingAngle, epsilon);
+}
@@ -1,98 +1,392 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <GLFW/glfw3.h>
 #include <vector>
-#include <functional>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
 
-#include "TextRender.hpp"
+#include "BarnesHut.hpp"
+#include "SpatialHash.hpp"
+#include "SmallFieldKernels.hpp"
+#include "PreciseFieldKernels.hpp"
+#include "VectorField.hpp"
+#include "FastMultipole.hpp"
+#include "ContinuousSources.hpp"
 
 class ElectricCharge {
     public:
-        ElectricCharge(float x, float y, float charge)
-            : position (x,y), charge(charge) {}
+        ElectricCharge(float x, float y, float charge, float mass = 1.0f)
+            : position (x,y), charge(charge), mass(mass), velocity(0.0f, 0.0f) {}
         
         glm::vec2 position;
         float charge;
+
+        // Only used by the dynamics mode
+        float mass;
+        glm::vec2 velocity;
+};
+
+// Structure-of-arrays copy of the charges, laid out for the batch kernels
+struct ChargeStorage {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> q;
+
+    size_t size() const { return q.size(); }
+
+    void push(float px, float py, float charge) {
+        x.push_back(px);
+        y.push_back(py);
+        q.push_back(charge);
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        q.clear();
+    }
+};
+
+// One charge that moved or changed value, for consumers that update incrementally
+struct ChargeDelta {
+    glm::vec2 oldPosition;
+    float oldCharge;
+    glm::vec2 newPosition;
+    float newCharge;
+};
+
+// Algorithm used to add up the contributions of the charges
+enum class FieldEngine {
+    Direct,     // Exact sum over every charge, O(N) per query
+    BarnesHut,  // Quadtree approximation, O(log N) per query
+    Multipole   // Fast multipole method, O(N + M) for M batch queries
 };
 
-class ElectricField {
+class ElectricField : public VectorField {
 public:
-    // Find a charge at a specific position (for mouse selection)
-    int findChargeAt(float x, float y, float radius = 0.1f) const {
-        for (size_t i = 0; i < charges.size(); i++) {
-            float dx = charges[i].position.x - x;
-            float dy = charges[i].position.y - y;
-            float distSquared = dx*dx + dy*dy;
-            if (distSquared < radius*radius) {
-                return static_cast<int>(i);
-            }
-        }
-        return -1; // No charge found
+    // Find a charge at a specific position (for mouse selection).
+    // Returns the lowest index among the charges within radius, skipping
+    // exclude.
+    int findChargeAt(float x, float y, float radius = 0.1f, int exclude = -1) const {
+        return chargeIndex.findLowestWithin(x, y, radius, storage.x.data(), storage.y.data(), exclude);
+    }
+
+    // Whether any charge is closer than radius to (x, y)
+    bool hasChargeWithin(float x, float y, float radius) const {
+        return chargeIndex.anyWithin(x, y, radius, storage.x.data(), storage.y.data());
     }
     
     // Move a charge to a new position
     void moveCharge(int index, float x, float y) {
         if (index >= 0 && index < static_cast<int>(charges.size())) {
+            ElectricCharge old = charges[index];
             charges[index].position.x = x;
             charges[index].position.y = y;
+            storage.x[index] = x;
+            storage.y[index] = y;
+            chargeIndex.move(index, x, y);
+            recordDelta(old, charges[index]);
         }
     }
 
     void changeChargeSize(int index, float delta) {
         if (index >= 0 && index < static_cast<int>(charges.size())) {
+            ElectricCharge old = charges[index];
             float scale_factor = 0.25f;
             charges[index].charge += delta * scale_factor;
             
             // Limits to prevent extreme values
             charges[index].charge = std::max(-5.0f, std::min(5.0f, charges[index].charge));
+            storage.q[index] = charges[index].charge;
+            recordDelta(old, charges[index]);
         }
         //std::cout << "void used" << std::endl;
     }
 
-    // Mouse Wheel checks
-    void mouseWheelUp(float yScroll);
-    void mouseWheelDown(float yScroll);
-
-    // Adds a charge to the field
-    void addCharge(float x, float y, float charge) {
-        charges.emplace_back(x, y, charge);
+    // Adds a charge to the field. The mass only matters to the dynamics
+    // mode; a mass <= 0 keeps the charge fixed there.
+    void addCharge(float x, float y, float charge, float mass = 1.0f) {
+        charges.emplace_back(x, y, charge, mass);
+        storage.push(x, y, charge);
+        chargeIndex.insert(static_cast<int>(charges.size() - 1), x, y);
+        markStructureChanged();
+    }
+    // Moves every charge at once (xs/ys hold one entry per charge). This is a
+    // structural change: consumers recompute instead of replaying N deltas.
+    void setPositions(const float* xs, const float* ys) {
+        for (size_t i = 0; i < charges.size(); i++) {
+            charges[i].position = glm::vec2(xs[i], ys[i]);
+            storage.x[i] = xs[i];
+            storage.y[i] = ys[i];
+        }
+        chargeIndex.rebuild(storage.x.data(), storage.y.data(), storage.size());
+        markStructureChanged();
+    }
+    // Replaces every charge at once from structure-of-arrays data (a loaded
+    // scene): three bulk copies instead of n addCharge calls. Without
+    // masses every charge gets mass 1.
+    void setCharges(const float* xs, const float* ys, const float* qs, size_t count,
+                    const float* masses = nullptr) {
+        storage.x.assign(xs, xs + count);
+        storage.y.assign(ys, ys + count);
+        storage.q.assign(qs, qs + count);
+        charges.clear();
+        charges.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            charges.emplace_back(xs[i], ys[i], qs[i], masses ? masses[i] : 1.0f);
+        }
+        chargeIndex.rebuild(storage.x.data(), storage.y.data(), storage.size());
+        markStructureChanged();
+    }
+    // Masses and velocities do not affect the field, so these are not changes
+    void setMass(int index, float mass) {
+        if (index >= 0 && index < static_cast<int>(charges.size())) charges[index].mass = mass;
+    }
+    void setVelocities(const float* vx, const float* vy) {
+        for (size_t i = 0; i < charges.size(); i++) {
+            charges[i].velocity = glm::vec2(vx[i], vy[i]);
+        }
     }
     // Clears all the charges from the field
     void clearCharges() {
         charges.clear();
+        storage.clear();
+        chargeIndex.clear();
+        markStructureChanged();
+    }
+
+    // Continuous sources (charged wires, rings, plates) evaluated in closed
+    // form and added to every field and potential query. Changing them is
+    // a structural change.
+    void addLineSource(glm::vec2 start, glm::vec2 end, float charge) {
+        sources.addLine(LineSource{start, end, charge});
+        markStructureChanged();
+    }
+    void addArcSource(glm::vec2 center, float radius, float startAngle, float endAngle, float charge) {
+        sources.addArc(ArcSource{center, radius, startAngle, endAngle, charge});
+        markStructureChanged();
+    }
+    void addRingSource(glm::vec2 center, float radius, float charge) {
+        addArcSource(center, radius, 0.0f, 6.28318531f, charge);
+    }
+    void addDiskSource(glm::vec2 center, float radius, float charge) {
+        sources.addDisk(DiskSource{center, radius, charge});
+        markStructureChanged();
+    }
+    void addPolygonSource(const std::vector<glm::vec2>& vertices, float charge) {
+        sources.addPolygon(PolygonSource{vertices, charge});
+        markStructureChanged();
     }
+    void clearSources() {
+        sources.clear();
+        markStructureChanged();
+    }
+    const ContinuousSources& getSources() const {
+        return sources;
+    }
+
     // Gets all charges
     const std::vector<ElectricCharge>& getCharges() const{
         return charges;
     }
+    // Gets the charges as structure-of-arrays
+    const ChargeStorage& getChargeStorage() const {
+        return storage;
+    }
+
+    // Selects the algorithm used by getFieldAt and getFieldAtBatch
+    void setEngine(FieldEngine newEngine) {
+        engine = newEngine;
+        markStructureChanged();
+    }
+    FieldEngine getEngine() const {
+        return engine;
+    }
+
+    // Barnes–Hut opening angle: error versus speed knob.
+    // 0 gives the exact sum, ~0.5 is a good default, ~1 is fast but coarse.
+    void setOpeningAngle(float theta) {
+        openingAngle = std::max(0.0f, theta);
+        markStructureChanged();
+    }
+    float getOpeningAngle() const {
+        return openingAngle;
+    }
+
+    // How the direct sum treats points closer than 0.1 to a charge: skipped
+    // (default), Plummer-softened or not at all. The tree and multipole
+    // engines always skip.
+    void setSofteningMode(SofteningMode mode) {
+        softening = mode;
+        markStructureChanged();
+    }
+    SofteningMode getSofteningMode() const {
+        return softening;
+    }
+
+    // Chebyshev order of the multipole engine: accuracy versus throughput
+    void setMultipoleOrder(int order) {
+        multipole.setOrder(order);
+        markStructureChanged();
+    }
+    int getMultipoleOrder() const {
+        return multipole.getOrder();
+    }
+
+    // Change tracking: the revision goes up on every change. Moves and value
+    // changes are logged as deltas; adding or clearing charges (or switching
+    // engine settings) is a structural change that drops the log.
+    uint64_t getRevision() const {
+        return revision;
+    }
+
+    // Appends the deltas made after `since` to out. Returns false if they are
+    // not all available (structural change or log overflow): recompute fully.
+    bool getDeltasSince(uint64_t since, std::vector<ChargeDelta>& out) const {
+        if (since == revision) return true;
+        if (since < structureRevision || since + 1 < deltaLogStart) return false;
+        for (uint64_t r = since + 1; r <= revision; r++) out.push_back(deltaLog[r % maxDeltaLog]);
+        return true;
+    }
 
     // Electric field calculation
-    glm::vec2 getFieldAt (float x, float y) const{
+    glm::vec2 getFieldAt(float x, float y) const {
+        glm::vec2 field = getChargeFieldAt(x, y);
+        if (!sources.empty()) field += sources.fieldAt(x, y);
+        return field;
+    }
+
+    // Field with an explicit accumulation mode, for readouts that need the
+    // cancellation between charges resolved (the sensor). Float is the usual
+    // fast path; the other modes always use the direct sum, since an engine's
+    // approximation error would swamp what they gain.
+    glm::vec2 getFieldAt(float x, float y, FieldPrecision precision) const;
+    void getFieldAtBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey,
+                         FieldPrecision precision) const;
+
+    // Electric field at n points at once, written to ex/ey (SIMD where available).
+    // The multipole engine only pays off here; single queries use the direct sum.
+    void getFieldAtBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey) const;
+
+    // Electric potential k*q/|r|. Distances under the 0.1 cutoff radius are
+    // clamped instead of skipped, so the potential is continuous (needed for
+    // contouring). The multipole engine falls back to the tree here.
+    float getPotentialAt(float x, float y) const {
+        float potential = getChargePotentialAt(x, y);
+        if (!sources.empty()) potential += sources.potentialAt(x, y);
+        return potential;
+    }
+
+    // Potential at n points at once, written to potential
+    void getPotentialAtBatch(const float* xs, const float* ys, size_t n, float* potential) const;
+
+    // VectorField: the batch path of the current engine
+    void sample(Span<const float> xs, Span<const float> ys, Span<float> ex, Span<float> ey) const override {
+        getFieldAtBatch(xs.data(), ys.data(), xs.size(), ex.data(), ey.data());
+    }
+
+private:
+    std::vector<ElectricCharge> charges;
+    ChargeStorage storage;
+    ContinuousSources sources;
+
+    // Charges bucketed by position for picking and proximity tests
+    SpatialHash chargeIndex{0.1f};
+
+    FieldEngine engine = FieldEngine::Direct;
+    SofteningMode softening = SofteningMode::HardCutoff;
+    float openingAngle = 0.5f;
+    FastMultipoleSolver multipole;
+
+    // Quadtree for the Barnes–Hut engine, rebuilt lazily after any change
+    mutable BarnesHutTree tree;
+    mutable std::atomic<bool> treeDirty{true};
+    mutable std::mutex treeMutex;
+
+    // Change tracking for incremental consumers
+    static constexpr size_t maxDeltaLog = 256;
+    uint64_t revision = 0;
+    uint64_t structureRevision = 0;
+    uint64_t deltaLogStart = 1;     // Oldest revision still in the log
+    std::vector<ChargeDelta> deltaLog;   // Ring: revision r at r % maxDeltaLog
+
+    void markChargesChanged() {
+        treeDirty.store(true, std::memory_order_release);
+    }
+
+    void markStructureChanged() {
+        revision++;
+        structureRevision = revision;
+        deltaLogStart = revision + 1;
+        markChargesChanged();
+    }
+
+    void recordDelta(const ElectricCharge& before, const ElectricCharge& after) {
+        revision++;
+        if (deltaLog.empty()) deltaLog.resize(maxDeltaLog);
+        deltaLog[revision % maxDeltaLog] = ChargeDelta{before.position, before.charge, after.position, after.charge};
+        if (revision - deltaLogStart >= maxDeltaLog) deltaLogStart++;
+        markChargesChanged();
+    }
+
+    // Rebuilds the tree if the charges changed since the last build
+    const BarnesHutTree& getTree() const;
+
+    glm::vec2 getFieldAtTree(float x, float y) const;
+    float getPotentialAtTree(float x, float y) const;
+
+    // The point charges alone, through the current engine
+    glm::vec2 getChargeFieldAt(float x, float y) const {
+        if (engine == FieldEngine::BarnesHut) return getFieldAtTree(x, y);
+
         const float k = 1.0f;
         const float epsilon = 0.01f; // Just to avoid division by 0
 
+        // Small scenes: unrolled kernel for this exact charge count
+        if (SmallFieldPointKernel kernel = selectSmallFieldPointKernel(storage.size(), softening)) {
+            glm::vec2 field;
+            kernel(storage.x.data(), storage.y.data(), storage.q.data(), x, y, epsilon, &field.x, &field.y);
+            return k * field;
+        }
+        if (softening != SofteningMode::HardCutoff) {
+            glm::vec2 field;
+            computeFieldBatchWithMode(softening, storage.x.data(), storage.y.data(), storage.q.data(), storage.size(),
+                                      &x, &y, 1, &field.x, &field.y, epsilon);
+            return k * field;
+        }
+
         glm::vec2 totalField(0.0f, 0.0f);
 
-        for(const auto& charge : charges) {
-            glm::vec2 r = glm::vec2(x,y) - charge.position;
+        for (size_t i = 0; i < storage.size(); i++) {
+            glm::vec2 r = glm::vec2(x - storage.x[i], y - storage.y[i]);
 
             float distSquared = glm::dot(r,r);
             if (distSquared < epsilon) continue;
-            float magnitude = k * charge.charge / distSquared;
-            glm::vec2 direction = glm::normalize(r);
-            totalField += magnitude * direction;
+            // k*q*r/|r|^3 has the k*q/|r|^2 magnitude along r
+            float invDist = 1.0f / std::sqrt(distSquared);
+            totalField += (k * storage.q[i] * invDist * invDist * invDist) * r;
         }
 
         return totalField;
     }
 
-    std::function<glm::vec2(float,float)> getVectorField() {
-        return [this](float x, float y) {
-            return this -> getFieldAt(x,y);
-        };
+    float getChargePotentialAt(float x, float y) const {
+        if (engine != FieldEngine::Direct) return getPotentialAtTree(x, y);
+
+        const float k = 1.0f;
+        const float epsilon = 0.01f;
+
+        float total = 0.0f;
+        for (size_t i = 0; i < storage.size(); i++) {
+            float dx = x - storage.x[i];
+            float dy = y - storage.y[i];
+            total += k * storage.q[i] / std::sqrt(std::max(dx*dx + dy*dy, epsilon));
+        }
+        return total;
     }
 
-private:
-    std::vector<ElectricCharge> charges;
+    void getChargeFieldAtBatch(const float* xs, const float* ys, size_t n, float* ex, float* ey) const;
 };
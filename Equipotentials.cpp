@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Equipotentials.hpp"
+#include "TaskScheduler.hpp"
+
+namespace {
+    // Cell edges: 0 bottom, 1 right, 2 top, 3 left. For each corner mask
+    // (bit 0 bottom-left, 1 bottom-right, 2 top-right, 3 top-left set when
+    // the corner is above the level) the two edges the line joins. Masks 0
+    // and 15 have no line and the saddles (5 and 10) are resolved separately.
+    const int segmentTable[16][2] = {
+        {-1, -1}, { 3,  0}, { 0,  1}, { 3,  1},
+        { 1,  2}, {-1, -1}, { 0,  2}, { 3,  2},
+        { 2,  3}, { 0,  2}, {-1, -1}, { 1,  2},
+        { 1,  3}, { 0,  1}, { 3,  0}, {-1, -1},
+    };
+
+    const size_t columnsPerBand = 16;
+}
+
+Equipotentials::Equipotentials() {
+    setLevels({-8.0f, -4.0f, -2.0f, -1.0f, -0.5f, -0.25f, 0.0f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f});
+}
+
+void Equipotentials::setLevels(const std::vector<float>& newLevels) {
+    levels = newLevels;
+    levelsChanged = true;
+}
+
+void Equipotentials::update(const FieldGrid& grid) {
+    if (!levelsChanged && sourceGrid == &grid && sourceVersion == grid.getVersion()) return;
+
+    size_t columns = grid.getColumnCount();
+    size_t cellColumns = columns > 1 ? columns - 1 : 0;
+    size_t bandCount = (cellColumns + columnsPerBand - 1) / columnsPerBand;
+    bands.resize(bandCount);
+
+    TaskScheduler::global().parallelFor(0, bandCount, 1, [&](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; band++) {
+            bands[band].clear();
+            size_t first = band * columnsPerBand;
+            size_t last = std::min(cellColumns, first + columnsPerBand);
+            extractColumns(grid, first, last, bands[band]);
+        }
+    });
+
+    vertices.clear();
+    for (const auto& band : bands) {
+        vertices.insert(vertices.end(), band.begin(), band.end());
+    }
+
+    sourceGrid = &grid;
+    sourceVersion = grid.getVersion();
+    levelsChanged = false;
+    version++;
+}
+
+void Equipotentials::extractColumns(const FieldGrid& grid, size_t begin, size_t end, std::vector<float>& out) const {
+    const std::vector<float>& xs = grid.getColumns();
+    const std::vector<float>& ys = grid.getRows();
+    size_t rows = ys.size();
+    if (rows < 2) return;
+
+    for (size_t c = begin; c < end; c++) {
+        for (size_t r = 0; r + 1 < rows; r++) {
+            // Corners counter-clockwise from the bottom left
+            float value[4] = {
+                grid.getPotential(c, r), grid.getPotential(c + 1, r),
+                grid.getPotential(c + 1, r + 1), grid.getPotential(c, r + 1),
+            };
+            if (!std::isfinite(value[0]) || !std::isfinite(value[1]) ||
+                !std::isfinite(value[2]) || !std::isfinite(value[3])) continue;
+
+            float x0 = xs[c], x1 = xs[c + 1];
+            float y0 = ys[r], y1 = ys[r + 1];
+            float low = std::min(std::min(value[0], value[1]), std::min(value[2], value[3]));
+            float high = std::max(std::max(value[0], value[1]), std::max(value[2], value[3]));
+
+            for (float level : levels) {
+                if (level < low || level > high) continue;
+
+                int mask = (value[0] > level ? 1 : 0) | (value[1] > level ? 2 : 0)
+                         | (value[2] > level ? 4 : 0) | (value[3] > level ? 8 : 0);
+                if (mask == 0 || mask == 15) continue;
+
+                // Point where the level crosses an edge, linearly interpolated
+                auto crossing = [&](int edge, float& px, float& py) {
+                    int a = edge, b = (edge + 1) % 4;
+                    float t = (level - value[a]) / (value[b] - value[a]);
+                    float ax = (a == 0 || a == 3) ? x0 : x1;
+                    float ay = (a == 0 || a == 1) ? y0 : y1;
+                    float bx = (b == 0 || b == 3) ? x0 : x1;
+                    float by = (b == 0 || b == 1) ? y0 : y1;
+                    px = ax + t * (bx - ax);
+                    py = ay + t * (by - ay);
+                };
+                auto emit = [&](int from, int to) {
+                    float px, py, qx, qy;
+                    crossing(from, px, py);
+                    crossing(to, qx, qy);
+                    out.push_back(px);
+                    out.push_back(py);
+                    out.push_back(qx);
+                    out.push_back(qy);
+                };
+
+                if (mask == 5 || mask == 10) {
+                    // Saddle: the average of the corners says whether the
+                    // two high corners are joined through the middle
+                    float centre = 0.25f * (value[0] + value[1] + value[2] + value[3]);
+                    bool highJoined = centre > level;
+                    if ((mask == 5) == highJoined) {
+                        emit(0, 1);
+                        emit(2, 3);
+                    } else {
+                        emit(3, 0);
+                        emit(1, 2);
+                    }
+                    continue;
+                }
+
+                const int* segment = segmentTable[mask];
+                emit(segment[0], segment[1]);
+            }
+        }
+    }
+}
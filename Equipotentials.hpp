@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "FieldGrid.hpp"
+
+// Equipotential lines extracted from the potential channel of a FieldGrid
+// with marching squares. Every grid cell is handled on its own, so the
+// extraction is split into column bands that run on the task scheduler.
+// The result is a flat list of line segments (x0, y0, x1, y1, ...) ready to
+// be drawn as GL_LINES, and it is only rebuilt when the grid or the levels
+// change, so leaving the lines on costs nothing while nothing moves.
+class Equipotentials {
+public:
+    Equipotentials();
+
+    // Potential values to draw a line at
+    void setLevels(const std::vector<float>& levels);
+    const std::vector<float>& getLevels() const { return levels; }
+
+    // Re-extracts the lines if the grid changed since the last call.
+    // The grid must have its potential channel enabled.
+    void update(const FieldGrid& grid);
+
+    // Segment end points, two vertices (four floats) per segment
+    const std::vector<float>& getVertices() const { return vertices; }
+    size_t getVertexCount() const { return vertices.size() / 2; }
+
+    // Bumped whenever the vertices change (to know when to re-upload them)
+    uint64_t getVersion() const { return version; }
+
+private:
+    std::vector<float> levels;
+    std::vector<float> vertices;
+    std::vector<std::vector<float>> bands;   // Per-task output, merged in order
+
+    const FieldGrid* sourceGrid = nullptr;
+    uint64_t sourceVersion = 0;
+    bool levelsChanged = true;
+    uint64_t version = 0;
+
+    void extractColumns(const FieldGrid& grid, size_t begin, size_t end, std::vector<float>& out) const;
+};
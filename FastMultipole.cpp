@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FastMultipole.hpp"
+#include "ElectricField.hpp"
+
+namespace {
+    const int minOrder = 2;
+    const int maxOrder = 8;
+    const int minLevel = 2;   // Interaction lists start at level 2
+    const int maxLevel = 8;   // 65536 leaves
+
+    // M2L offsets live in [-3, 3]^2; the table is indexed by (dx + 3) * 7 + (dy + 3)
+    const int offsetSpan = 7;
+
+    int offsetIndex(int dx, int dy) {
+        return (dx + 3) * offsetSpan + (dy + 3);
+    }
+
+    // Boxes of one level of the uniform quadtree, row-major by (ix, iy)
+    struct Level {
+        int side;
+        float halfWidth;
+        std::vector<float> multipole;   // p^2 source weights per box
+        std::vector<float> localX;      // p^2 field values per box
+        std::vector<float> localY;
+        std::vector<char> hasSources;
+        std::vector<char> hasTargets;
+    };
+
+    // Sorts points into leaf boxes; start has side^2 + 1 entries
+    void binPoints(const float* xs, const float* ys, size_t n, float originX, float originY,
+                   float leafWidth, int side, std::vector<int>& start, std::vector<int>& order) {
+        std::vector<int> leafOf(n);
+        start.assign(side * side + 1, 0);
+        for (size_t i = 0; i < n; i++) {
+            int ix = std::min(side - 1, std::max(0, static_cast<int>((xs[i] - originX) / leafWidth)));
+            int iy = std::min(side - 1, std::max(0, static_cast<int>((ys[i] - originY) / leafWidth)));
+            leafOf[i] = iy * side + ix;
+            start[leafOf[i] + 1]++;
+        }
+        for (int b = 0; b < side * side; b++) start[b + 1] += start[b];
+
+        std::vector<int> cursor(start.begin(), start.end() - 1);
+        order.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            order[cursor[leafOf[i]]++] = static_cast<int>(i);
+        }
+    }
+
+    // out[a][b] (+)= sum_c sum_d mx[a][c] my[b][d] in[c][d], all p x p
+    void applySeparable(const float* mx, const float* my, const float* in, float* out, int p) {
+        float tmp[maxOrder * maxOrder];
+        for (int a = 0; a < p; a++) {
+            for (int d = 0; d < p; d++) {
+                float sum = 0.0f;
+                for (int c = 0; c < p; c++) sum += mx[a * p + c] * in[c * p + d];
+                tmp[a * p + d] = sum;
+            }
+        }
+        for (int a = 0; a < p; a++) {
+            for (int b = 0; b < p; b++) {
+                float sum = 0.0f;
+                for (int d = 0; d < p; d++) sum += my[b * p + d] * tmp[a * p + d];
+                out[a * p + b] += sum;
+            }
+        }
+    }
+
+    // Same as applySeparable with both matrices transposed (used by L2L)
+    void applySeparableTransposed(const float* mx, const float* my, const float* in, float* out, int p) {
+        float tmp[maxOrder * maxOrder];
+        for (int c = 0; c < p; c++) {
+            for (int b = 0; b < p; b++) {
+                float sum = 0.0f;
+                for (int a = 0; a < p; a++) sum += mx[a * p + c] * in[a * p + b];
+                tmp[c * p + b] = sum;
+            }
+        }
+        for (int c = 0; c < p; c++) {
+            for (int d = 0; d < p; d++) {
+                float sum = 0.0f;
+                for (int b = 0; b < p; b++) sum += my[b * p + d] * tmp[c * p + b];
+                out[c * p + d] += sum;
+            }
+        }
+    }
+}
+
+FastMultipoleSolver::FastMultipoleSolver(int order) {
+    setOrder(order);
+}
+
+void FastMultipoleSolver::setOrder(int newOrder) {
+    order = std::max(minOrder, std::min(maxOrder, newOrder));
+    precompute();
+}
+
+void FastMultipoleSolver::interpolationWeights(float u, float* weights) const {
+    // S_p(u, x_a) = 1/p + 2/p * sum_{j=1}^{p-1} T_j(u) T_j(x_a)
+    int p = order;
+    float tu[maxOrder];
+    tu[0] = 1.0f;
+    if (p > 1) tu[1] = u;
+    for (int j = 2; j < p; j++) tu[j] = 2.0f * u * tu[j - 1] - tu[j - 2];
+
+    for (int a = 0; a < p; a++) {
+        float xa = nodes[a];
+        float tPrev = 1.0f, tCur = xa;
+        float sum = 0.0f;
+        for (int j = 1; j < p; j++) {
+            sum += tu[j] * tCur;
+            float tNext = 2.0f * xa * tCur - tPrev;
+            tPrev = tCur;
+            tCur = tNext;
+        }
+        weights[a] = (1.0f + 2.0f * sum) / p;
+    }
+}
+
+void FastMultipoleSolver::precompute() {
+    int p = order;
+    int p2 = p * p;
+
+    nodes.resize(p);
+    for (int a = 0; a < p; a++) {
+        nodes[a] = static_cast<float>(std::cos((2.0 * a + 1.0) * M_PI / (2.0 * p)));
+    }
+
+    // Child nodes seen from the parent box, for the lower (s = -1) and upper (s = +1) child
+    childToParent.assign(2 * p2, 0.0f);
+    float weights[maxOrder];
+    for (int side = 0; side < 2; side++) {
+        float shift = side == 0 ? -1.0f : 1.0f;
+        for (int c = 0; c < p; c++) {
+            interpolationWeights((nodes[c] + shift) * 0.5f, weights);
+            for (int a = 0; a < p; a++) childToParent[side * p2 + a * p + c] = weights[a];
+        }
+    }
+
+    // Kernel between node grids of two unit boxes (half width 1) that are
+    // (dx, dy) boxes apart; real boxes scale the field by 1 / halfWidth^2
+    int tableSize = offsetSpan * offsetSpan;
+    transferX.assign(static_cast<size_t>(tableSize) * p2 * p2, 0.0f);
+    transferY.assign(static_cast<size_t>(tableSize) * p2 * p2, 0.0f);
+    for (int dx = -3; dx <= 3; dx++) {
+        for (int dy = -3; dy <= 3; dy++) {
+            if (std::abs(dx) <= 1 && std::abs(dy) <= 1) continue;
+            size_t base = static_cast<size_t>(offsetIndex(dx, dy)) * p2 * p2;
+            for (int t = 0; t < p2; t++) {
+                double tx = nodes[t / p];
+                double ty = nodes[t % p];
+                for (int s = 0; s < p2; s++) {
+                    double rx = tx - (2.0 * dx + nodes[s / p]);
+                    double ry = ty - (2.0 * dy + nodes[s % p]);
+                    double dist2 = rx * rx + ry * ry;
+                    double inv3 = 1.0 / (dist2 * std::sqrt(dist2));
+                    transferX[base + t * p2 + s] = static_cast<float>(rx * inv3);
+                    transferY[base + t * p2 + s] = static_cast<float>(ry * inv3);
+                }
+            }
+        }
+    }
+}
+
+void FastMultipoleSolver::evaluate(const ChargeStorage& charges, const float* xs, const float* ys, size_t n,
+                                   float* ex, float* ey, float cutoff2) const {
+    std::fill(ex, ex + n, 0.0f);
+    std::fill(ey, ey + n, 0.0f);
+    size_t count = charges.size();
+    if (count == 0 || n == 0) return;
+
+    const int p = order;
+    const int p2 = p * p;
+
+    // Square domain around sources and targets
+    float minX = charges.x[0], maxX = charges.x[0];
+    float minY = charges.y[0], maxY = charges.y[0];
+    for (size_t i = 0; i < count; i++) {
+        minX = std::min(minX, charges.x[i]); maxX = std::max(maxX, charges.x[i]);
+        minY = std::min(minY, charges.y[i]); maxY = std::max(maxY, charges.y[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        minX = std::min(minX, xs[i]); maxX = std::max(maxX, xs[i]);
+        minY = std::min(minY, ys[i]); maxY = std::max(maxY, ys[i]);
+    }
+    float halfDomain = std::max(maxX - minX, maxY - minY) * 0.5f * 1.001f + 1e-4f;
+    float originX = (minX + maxX) * 0.5f - halfDomain;
+    float originY = (minY + maxY) * 0.5f - halfDomain;
+
+    // Balance near-field work (M * N / 4^L) against M2L work (4^L * p^4)
+    double balance = std::sqrt(static_cast<double>(count) * n) / (3.0 * p2);
+    int levels = static_cast<int>(std::lround(std::log(std::max(balance, 1.0)) / std::log(4.0)));
+    levels = std::max(minLevel, std::min(maxLevel, levels));
+
+    std::vector<Level> tree(levels + 1);
+    for (int l = 0; l <= levels; l++) {
+        Level& level = tree[l];
+        level.side = 1 << l;
+        level.halfWidth = halfDomain / level.side;
+        size_t boxes = static_cast<size_t>(level.side) * level.side;
+        level.hasSources.assign(boxes, 0);
+        level.hasTargets.assign(boxes, 0);
+        if (l >= minLevel) {
+            level.multipole.assign(boxes * p2, 0.0f);
+            level.localX.assign(boxes * p2, 0.0f);
+            level.localY.assign(boxes * p2, 0.0f);
+        }
+    }
+
+    Level& leaves = tree[levels];
+    const int side = leaves.side;
+    const float leafWidth = 2.0f * leaves.halfWidth;
+
+    std::vector<int> sourceStart, sourceOrder, targetStart, targetOrder;
+    binPoints(charges.x.data(), charges.y.data(), count, originX, originY, leafWidth, side, sourceStart, sourceOrder);
+    binPoints(xs, ys, n, originX, originY, leafWidth, side, targetStart, targetOrder);
+
+    // Sorted copies of the sources for cache-friendly leaf loops
+    std::vector<float> sx(count), sy(count), sq(count);
+    for (size_t k = 0; k < count; k++) {
+        sx[k] = charges.x[sourceOrder[k]];
+        sy[k] = charges.y[sourceOrder[k]];
+        sq[k] = charges.q[sourceOrder[k]];
+    }
+
+    auto boxCenter = [&](const Level& level, int ix, int iy, float& cx, float& cy) {
+        cx = originX + (2 * ix + 1) * level.halfWidth;
+        cy = originY + (2 * iy + 1) * level.halfWidth;
+    };
+
+    // Occupancy of every level
+    for (int b = 0; b < side * side; b++) {
+        leaves.hasSources[b] = sourceStart[b + 1] > sourceStart[b];
+        leaves.hasTargets[b] = targetStart[b + 1] > targetStart[b];
+    }
+    for (int l = levels - 1; l >= 0; l--) {
+        Level& level = tree[l];
+        const Level& child = tree[l + 1];
+        for (int iy = 0; iy < child.side; iy++) {
+            for (int ix = 0; ix < child.side; ix++) {
+                int parent = (iy / 2) * level.side + ix / 2;
+                level.hasSources[parent] |= child.hasSources[iy * child.side + ix];
+                level.hasTargets[parent] |= child.hasTargets[iy * child.side + ix];
+            }
+        }
+    }
+
+    float wx[maxOrder], wy[maxOrder];
+
+    // P2M: charges to weights on the leaf's Chebyshev grid
+    for (int b = 0; b < side * side; b++) {
+        if (!leaves.hasSources[b]) continue;
+        float cx, cy;
+        boxCenter(leaves, b % side, b / side, cx, cy);
+        float* weightsOut = &leaves.multipole[static_cast<size_t>(b) * p2];
+        for (int k = sourceStart[b]; k < sourceStart[b + 1]; k++) {
+            interpolationWeights((sx[k] - cx) / leaves.halfWidth, wx);
+            interpolationWeights((sy[k] - cy) / leaves.halfWidth, wy);
+            for (int a = 0; a < p; a++) {
+                float qa = sq[k] * wx[a];
+                for (int c = 0; c < p; c++) weightsOut[a * p + c] += qa * wy[c];
+            }
+        }
+    }
+
+    // M2M: children to parents
+    for (int l = levels - 1; l >= minLevel; l--) {
+        Level& level = tree[l];
+        const Level& child = tree[l + 1];
+        for (int iy = 0; iy < child.side; iy++) {
+            for (int ix = 0; ix < child.side; ix++) {
+                int c = iy * child.side + ix;
+                if (!child.hasSources[c]) continue;
+                int parent = (iy / 2) * level.side + ix / 2;
+                applySeparable(&childToParent[(ix & 1) * p2], &childToParent[(iy & 1) * p2],
+                               &child.multipole[static_cast<size_t>(c) * p2],
+                               &level.multipole[static_cast<size_t>(parent) * p2], p);
+            }
+        }
+    }
+
+    // M2L: well-separated boxes whose parents are neighbours
+    for (int l = minLevel; l <= levels; l++) {
+        Level& level = tree[l];
+        float scale = 1.0f / (level.halfWidth * level.halfWidth);
+        for (int by = 0; by < level.side; by++) {
+            for (int bx = 0; bx < level.side; bx++) {
+                int b = by * level.side + bx;
+                if (!level.hasTargets[b]) continue;
+
+                float* outX = &level.localX[static_cast<size_t>(b) * p2];
+                float* outY = &level.localY[static_cast<size_t>(b) * p2];
+                int px = bx / 2, py = by / 2;
+
+                for (int sy2 = 2 * (py - 1); sy2 <= 2 * (py + 1) + 1; sy2++) {
+                    for (int sx2 = 2 * (px - 1); sx2 <= 2 * (px + 1) + 1; sx2++) {
+                        if (sx2 < 0 || sy2 < 0 || sx2 >= level.side || sy2 >= level.side) continue;
+                        int dx = sx2 - bx, dy = sy2 - by;
+                        if (std::abs(dx) <= 1 && std::abs(dy) <= 1) continue;
+                        int s = sy2 * level.side + sx2;
+                        if (!level.hasSources[s]) continue;
+
+                        const float* weightsIn = &level.multipole[static_cast<size_t>(s) * p2];
+                        size_t base = static_cast<size_t>(offsetIndex(dx, dy)) * p2 * p2;
+                        for (int t = 0; t < p2; t++) {
+                            const float* rowX = &transferX[base + t * p2];
+                            const float* rowY = &transferY[base + t * p2];
+                            float sumX = 0.0f, sumY = 0.0f;
+                            for (int k = 0; k < p2; k++) {
+                                sumX += rowX[k] * weightsIn[k];
+                                sumY += rowY[k] * weightsIn[k];
+                            }
+                            outX[t] += scale * sumX;
+                            outY[t] += scale * sumY;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // L2L: parents to children
+    for (int l = minLevel; l < levels; l++) {
+        const Level& level = tree[l];
+        Level& child = tree[l + 1];
+        for (int iy = 0; iy < child.side; iy++) {
+            for (int ix = 0; ix < child.side; ix++) {
+                int c = iy * child.side + ix;
+                if (!child.hasTargets[c]) continue;
+                int parent = (iy / 2) * level.side + ix / 2;
+                applySeparableTransposed(&childToParent[(ix & 1) * p2], &childToParent[(iy & 1) * p2],
+                                         &level.localX[static_cast<size_t>(parent) * p2],
+                                         &child.localX[static_cast<size_t>(c) * p2], p);
+                applySeparableTransposed(&childToParent[(ix & 1) * p2], &childToParent[(iy & 1) * p2],
+                                         &level.localY[static_cast<size_t>(parent) * p2],
+                                         &child.localY[static_cast<size_t>(c) * p2], p);
+            }
+        }
+    }
+
+    // Far charges closer than the cutoff were counted by the expansions but are
+    // skipped by the direct sum; remove them when leaves are smaller than the cutoff
+    int cutoffRing = static_cast<int>(std::ceil(std::sqrt(cutoff2) / leafWidth));
+
+    // L2P + P2P at the leaves
+    for (int b = 0; b < side * side; b++) {
+        if (!leaves.hasTargets[b]) continue;
+        int bx = b % side, by = b / side;
+        float cx, cy;
+        boxCenter(leaves, bx, by, cx, cy);
+        const float* localX = &leaves.localX[static_cast<size_t>(b) * p2];
+        const float* localY = &leaves.localY[static_cast<size_t>(b) * p2];
+
+        for (int k = targetStart[b]; k < targetStart[b + 1]; k++) {
+            int t = targetOrder[k];
+            float x = xs[t], y = ys[t];
+
+            interpolationWeights((x - cx) / leaves.halfWidth, wx);
+            interpolationWeights((y - cy) / leaves.halfWidth, wy);
+            float fieldX = 0.0f, fieldY = 0.0f;
+            for (int a = 0; a < p; a++) {
+                float rowX = 0.0f, rowY = 0.0f;
+                for (int c = 0; c < p; c++) {
+                    rowX += wy[c] * localX[a * p + c];
+                    rowY += wy[c] * localY[a * p + c];
+                }
+                fieldX += wx[a] * rowX;
+                fieldY += wx[a] * rowY;
+            }
+
+            int ring = std::max(1, cutoffRing);
+            for (int ny = std::max(0, by - ring); ny <= std::min(side - 1, by + ring); ny++) {
+                for (int nx = std::max(0, bx - ring); nx <= std::min(side - 1, bx + ring); nx++) {
+                    int nb = ny * side + nx;
+                    bool near = std::abs(nx - bx) <= 1 && std::abs(ny - by) <= 1;
+                    for (int s = sourceStart[nb]; s < sourceStart[nb + 1]; s++) {
+                        float rx = x - sx[s];
+                        float ry = y - sy[s];
+                        float d2 = rx*rx + ry*ry;
+                        if (near) {
+                            if (d2 < cutoff2) continue;
+                        } else if (d2 >= cutoff2) {
+                            continue;
+                        }
+                        float invDist = 1.0f / std::sqrt(d2);
+                        float contribution = sq[s] * invDist * invDist * invDist;
+                        // Near boxes are added exactly, far ones inside the cutoff are subtracted
+                        if (!near) contribution = -contribution;
+                        fieldX += contribution * rx;
+                        fieldY += contribution * ry;
+                    }
+                }
+            }
+
+            ex[t] = fieldX;
+            ey[t] = fieldY;
+        }
+    }
+}
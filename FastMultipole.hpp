@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+struct ChargeStorage;
+
+// Fast Multipole Method for evaluating the field of N charges at M targets
+// in O(N + M). The field kernel here is q * r / |r|^3 (a 1/r potential), which
+// is not harmonic in the plane, so the complex power series of the classic
+// 2D FMM do not apply. Multipole and local expansions are instead stored as
+// values on a p x p grid of Chebyshev nodes per box (black-box FMM), which
+// works for any smooth kernel. The order p trades accuracy for throughput:
+// the error falls roughly geometrically with p, M2L cost grows as p^4.
+class FastMultipoleSolver {
+public:
+    FastMultipoleSolver(int order = 4);
+
+    // Number of Chebyshev nodes per dimension, clamped to [2, 8]
+    void setOrder(int order);
+    int getOrder() const { return order; }
+
+    // Field of the charges at n targets, written to ex/ey. Charges closer
+    // than sqrt(cutoff2) to a target are skipped, like the direct sum.
+    void evaluate(const ChargeStorage& charges, const float* xs, const float* ys, size_t n,
+                  float* ex, float* ey, float cutoff2) const;
+
+private:
+    int order;
+    std::vector<float> nodes;        // Chebyshev nodes on [-1, 1]
+    std::vector<float> childToParent; // [side][a * p + c]: S((x_c + s) / 2, x_a)
+    std::vector<float> transferX;    // M2L matrices per offset, x component
+    std::vector<float> transferY;    // M2L matrices per offset, y component
+
+    void precompute();
+
+    // Interpolation weights S(u, x_a) for all nodes a
+    void interpolationWeights(float u, float* weights) const;
+};
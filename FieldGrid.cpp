@@ -0,0 +1,119 @@
+#include "FieldGrid.hpp"
+#include "FieldKernels.hpp"
+#include "Profiler.hpp"
+#include "TaskScheduler.hpp"
+
+namespace {
+    const float epsilon = 0.01f;     // Same cutoff as ElectricField::getFieldAt
+    const size_t chunkSize = 1024;   // Grid points per task
+}
+
+void FieldGrid::setLayout(float newXMin, float newXMax, float newYMin, float newYMax, float newSpacing) {
+    if (valid && newXMin == xMin && newXMax == xMax && newYMin == yMin && newYMax == yMax && newSpacing == spacing) {
+        return;
+    }
+
+    xMin = newXMin;
+    xMax = newXMax;
+    yMin = newYMin;
+    yMax = newYMax;
+    spacing = newSpacing;
+
+    // Same float stepping as the original grid loop, so the points match it
+    columns.clear();
+    for (float x = xMin; x <= xMax; x += spacing) columns.push_back(x);
+    rows.clear();
+    for (float y = yMin; y <= yMax; y += spacing) rows.push_back(y);
+
+    pointX.clear();
+    pointY.clear();
+    for (float x : columns) {
+        for (float y : rows) {
+            pointX.push_back(x);
+            pointY.push_back(y);
+        }
+    }
+    fieldX.assign(cacheField ? pointX.size() : 0, 0.0f);
+    fieldY.assign(cacheField ? pointY.size() : 0, 0.0f);
+    potential.assign(cachePotential ? pointX.size() : 0, 0.0f);
+
+    valid = false;
+}
+
+void FieldGrid::setChannels(bool field, bool potentialChannel) {
+    if (field == cacheField && potentialChannel == cachePotential) return;
+
+    cacheField = field;
+    cachePotential = potentialChannel;
+    fieldX.assign(cacheField ? pointX.size() : 0, 0.0f);
+    fieldY.assign(cacheField ? pointY.size() : 0, 0.0f);
+    potential.assign(cachePotential ? pointX.size() : 0, 0.0f);
+    valid = false;
+}
+
+void FieldGrid::recomputeAll(const ElectricField& field) {
+    PROFILE_ZONE("FieldGrid::recomputeAll");
+    TaskScheduler& scheduler = TaskScheduler::global();
+
+    if (cacheField) {
+        // The multipole engine works best with all targets at once
+        if (field.getEngine() == FieldEngine::Multipole) {
+            field.getFieldAtBatch(pointX.data(), pointY.data(), pointX.size(), fieldX.data(), fieldY.data());
+        } else {
+            scheduler.parallelFor(0, pointX.size(), chunkSize, [&](size_t begin, size_t end) {
+                field.getFieldAtBatch(pointX.data() + begin, pointY.data() + begin, end - begin,
+                                      fieldX.data() + begin, fieldY.data() + begin);
+            });
+        }
+    }
+
+    if (cachePotential) {
+        scheduler.parallelFor(0, pointX.size(), chunkSize, [&](size_t begin, size_t end) {
+            field.getPotentialAtBatch(pointX.data() + begin, pointY.data() + begin, end - begin,
+                                      potential.data() + begin);
+        });
+    }
+
+    valid = true;
+    deltasSinceRefresh = 0;
+    fullUpdates++;
+}
+
+void FieldGrid::sync(const ElectricField& field) {
+    uint64_t current = field.getRevision();
+    if (valid && current == revision) return;
+
+    pending.clear();
+    // The deltas are exact hard-cutoff sums, so other softening modes and
+    // the approximate engines always recompute; mixing the two would leave
+    // the moved charges' regions more accurate than the rest of the grid
+    bool incremental = valid && field.getSofteningMode() == SofteningMode::HardCutoff
+                    && field.getEngine() == FieldEngine::Direct
+                    && field.getDeltasSince(revision, pending)
+                    && deltasSinceRefresh + static_cast<int>(pending.size()) < refreshInterval;
+
+    if (!incremental) {
+        recomputeAll(field);
+    } else {
+        TaskScheduler::global().parallelFor(0, pointX.size(), chunkSize, [&](size_t begin, size_t end) {
+            for (const ChargeDelta& delta : pending) {
+                if (cacheField) {
+                    applyChargeDelta(delta.oldPosition.x, delta.oldPosition.y, delta.oldCharge,
+                                     delta.newPosition.x, delta.newPosition.y, delta.newCharge,
+                                     pointX.data() + begin, pointY.data() + begin, end - begin,
+                                     fieldX.data() + begin, fieldY.data() + begin, epsilon);
+                }
+                if (cachePotential) {
+                    applyPotentialDelta(delta.oldPosition.x, delta.oldPosition.y, delta.oldCharge,
+                                        delta.newPosition.x, delta.newPosition.y, delta.newCharge,
+                                        pointX.data() + begin, pointY.data() + begin, end - begin,
+                                        potential.data() + begin, epsilon);
+                }
+            }
+        });
+        deltasSinceRefresh += static_cast<int>(pending.size());
+    }
+
+    revision = current;
+    version++;
+}
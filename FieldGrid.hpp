@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ElectricField.hpp"
+
+// Electric field (and optionally the potential) cached on a regular grid
+// of sample points.
+// sync() brings the cache up to date: when only a few charges moved or
+// changed value since the last sync, their old contribution is subtracted
+// and the new one added (O(grid) per changed charge) instead of summing
+// every charge again (O(grid x N)). Any structural change, or a layout
+// change, recomputes everything, and so does every refreshInterval-th
+// delta to keep float round-off from piling up. Deltas are exact sums, so
+// only the direct engine uses them; the tree engines always recompute.
+class FieldGrid {
+public:
+    // Sample points x = xMin + i * spacing <= xMax (same for y); a new layout
+    // invalidates the cache
+    void setLayout(float xMin, float xMax, float yMin, float yMax, float spacing);
+
+    // Updates the cached values for the current state of the field
+    void sync(const ElectricField& field);
+
+    // Which quantities to cache (field only by default); changing them
+    // invalidates the cache
+    void setChannels(bool field, bool potential);
+
+    // Deltas applied between two full recomputations
+    void setRefreshInterval(int deltas) { refreshInterval = deltas > 0 ? deltas : 1; }
+
+    size_t getColumnCount() const { return columns.size(); }
+    size_t getRowCount() const { return rows.size(); }
+    const std::vector<float>& getColumns() const { return columns; }
+    const std::vector<float>& getRows() const { return rows; }
+
+    // Cached field at column c, row r
+    glm::vec2 getField(size_t c, size_t r) const {
+        size_t i = c * rows.size() + r;
+        return glm::vec2(fieldX[i], fieldY[i]);
+    }
+
+    // Cached potential at column c, row r (potential channel only)
+    float getPotential(size_t c, size_t r) const {
+        return potential[c * rows.size() + r];
+    }
+
+    // Bumped whenever the cached values change, so derived data (contours)
+    // can tell when it is stale
+    uint64_t getVersion() const { return version; }
+
+    // Number of full recomputations so far (for diagnostics)
+    uint64_t getFullUpdates() const { return fullUpdates; }
+
+private:
+    float xMin = 0.0f, xMax = 0.0f, yMin = 0.0f, yMax = 0.0f, spacing = 0.0f;
+    std::vector<float> columns, rows;
+
+    // Sample points and cached values, column-major (x outer, y inner)
+    std::vector<float> pointX, pointY;
+    std::vector<float> fieldX, fieldY;
+    std::vector<float> potential;
+
+    bool cacheField = true;
+    bool cachePotential = false;
+
+    bool valid = false;
+    uint64_t revision = 0;
+    int deltasSinceRefresh = 0;
+    int refreshInterval = 64;
+    uint64_t fullUpdates = 0;
+    uint64_t version = 0;
+    std::vector<ChargeDelta> pending;
+
+    void recomputeAll(const ElectricField& field);
+};
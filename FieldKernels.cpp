@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FieldKernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+void computeFieldBatchScalar(const float* cx, const float* cy, const float* cq, size_t count,
+                             const float* xs, const float* ys, size_t n,
+                             float* ex, float* ey, float cutoff2) {
+    for (size_t t = 0; t < n; t++) {
+        float sumX = 0.0f;
+        float sumY = 0.0f;
+
+        for (size_t i = 0; i < count; i++) {
+            float rx = xs[t] - cx[i];
+            float ry = ys[t] - cy[i];
+            float distSquared = rx*rx + ry*ry;
+            if (distSquared < cutoff2) continue;
+
+            // q / |r|^3, so that q * r / |r|^3 has magnitude q / |r|^2
+            float invDist = 1.0f / std::sqrt(distSquared);
+            float scale = cq[i] * invDist * invDist * invDist;
+            sumX += scale * rx;
+            sumY += scale * ry;
+        }
+
+        ex[t] = sumX;
+        ey[t] = sumY;
+    }
+}
+
+#if defined(__AVX2__)
+
+// 8 targets per iteration, one charge broadcast at a time
+static void computeFieldBatchAVX2(const float* cx, const float* cy, const float* cq, size_t count,
+                                  const float* xs, const float* ys, size_t n,
+                                  float* ex, float* ey, float cutoff2) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 cutoff = _mm256_set1_ps(cutoff2);
+
+    size_t t = 0;
+    for (; t + 8 <= n; t += 8) {
+        __m256 px = _mm256_loadu_ps(xs + t);
+        __m256 py = _mm256_loadu_ps(ys + t);
+        __m256 sumX = _mm256_setzero_ps();
+        __m256 sumY = _mm256_setzero_ps();
+
+        for (size_t i = 0; i < count; i++) {
+            __m256 rx = _mm256_sub_ps(px, _mm256_set1_ps(cx[i]));
+            __m256 ry = _mm256_sub_ps(py, _mm256_set1_ps(cy[i]));
+#if defined(__FMA__)
+            __m256 distSquared = _mm256_fmadd_ps(rx, rx, _mm256_mul_ps(ry, ry));
+#else
+            __m256 distSquared = _mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry));
+#endif
+            __m256 keep = _mm256_cmp_ps(distSquared, cutoff, _CMP_GE_OQ);
+
+            __m256 invDist = _mm256_div_ps(one, _mm256_sqrt_ps(distSquared));
+            __m256 scale = _mm256_mul_ps(_mm256_mul_ps(invDist, invDist), invDist);
+            scale = _mm256_and_ps(_mm256_mul_ps(scale, _mm256_set1_ps(cq[i])), keep);
+
+#if defined(__FMA__)
+            sumX = _mm256_fmadd_ps(scale, rx, sumX);
+            sumY = _mm256_fmadd_ps(scale, ry, sumY);
+#else
+            sumX = _mm256_add_ps(sumX, _mm256_mul_ps(scale, rx));
+            sumY = _mm256_add_ps(sumY, _mm256_mul_ps(scale, ry));
+#endif
+        }
+
+        _mm256_storeu_ps(ex + t, sumX);
+        _mm256_storeu_ps(ey + t, sumY);
+    }
+
+    computeFieldBatchScalar(cx, cy, cq, count, xs + t, ys + t, n - t, ex + t, ey + t, cutoff2);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+// 4 targets per iteration, one charge broadcast at a time
+static void computeFieldBatchSSE(const float* cx, const float* cy, const float* cq, size_t count,
+                                 const float* xs, const float* ys, size_t n,
+                                 float* ex, float* ey, float cutoff2) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 cutoff = _mm_set1_ps(cutoff2);
+
+    size_t t = 0;
+    for (; t + 4 <= n; t += 4) {
+        __m128 px = _mm_loadu_ps(xs + t);
+        __m128 py = _mm_loadu_ps(ys + t);
+        __m128 sumX = _mm_setzero_ps();
+        __m128 sumY = _mm_setzero_ps();
+
+        for (size_t i = 0; i < count; i++) {
+            __m128 rx = _mm_sub_ps(px, _mm_set1_ps(cx[i]));
+            __m128 ry = _mm_sub_ps(py, _mm_set1_ps(cy[i]));
+            __m128 distSquared = _mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry));
+            __m128 keep = _mm_cmpge_ps(distSquared, cutoff);
+
+            __m128 invDist = _mm_div_ps(one, _mm_sqrt_ps(distSquared));
+            __m128 scale = _mm_mul_ps(_mm_mul_ps(invDist, invDist), invDist);
+            scale = _mm_and_ps(_mm_mul_ps(scale, _mm_set1_ps(cq[i])), keep);
+
+            sumX = _mm_add_ps(sumX, _mm_mul_ps(scale, rx));
+            sumY = _mm_add_ps(sumY, _mm_mul_ps(scale, ry));
+        }
+
+        _mm_storeu_ps(ex + t, sumX);
+        _mm_storeu_ps(ey + t, sumY);
+    }
+
+    computeFieldBatchScalar(cx, cy, cq, count, xs + t, ys + t, n - t, ex + t, ey + t, cutoff2);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+// 4 targets per iteration, one charge broadcast at a time
+static void computeFieldBatchNEON(const float* cx, const float* cy, const float* cq, size_t count,
+                                  const float* xs, const float* ys, size_t n,
+                                  float* ex, float* ey, float cutoff2) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t cutoff = vdupq_n_f32(cutoff2);
+
+    size_t t = 0;
+    for (; t + 4 <= n; t += 4) {
+        float32x4_t px = vld1q_f32(xs + t);
+        float32x4_t py = vld1q_f32(ys + t);
+        float32x4_t sumX = vdupq_n_f32(0.0f);
+        float32x4_t sumY = vdupq_n_f32(0.0f);
+
+        for (size_t i = 0; i < count; i++) {
+            float32x4_t rx = vsubq_f32(px, vdupq_n_f32(cx[i]));
+            float32x4_t ry = vsubq_f32(py, vdupq_n_f32(cy[i]));
+            float32x4_t distSquared = vfmaq_f32(vmulq_f32(ry, ry), rx, rx);
+            uint32x4_t keep = vcgeq_f32(distSquared, cutoff);
+
+            float32x4_t invDist = vdivq_f32(one, vsqrtq_f32(distSquared));
+            float32x4_t scale = vmulq_f32(vmulq_f32(invDist, invDist), invDist);
+            scale = vmulq_f32(scale, vdupq_n_f32(cq[i]));
+            scale = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(scale), keep));
+
+            sumX = vfmaq_f32(sumX, scale, rx);
+            sumY = vfmaq_f32(sumY, scale, ry);
+        }
+
+        vst1q_f32(ex + t, sumX);
+        vst1q_f32(ey + t, sumY);
+    }
+
+    computeFieldBatchScalar(cx, cy, cq, count, xs + t, ys + t, n - t, ex + t, ey + t, cutoff2);
+}
+
+#endif
+
+void computeFieldBatch(const float* cx, const float* cy, const float* cq, size_t count,
+                       const float* xs, const float* ys, size_t n,
+                       float* ex, float* ey, float cutoff2) {
+#if defined(__AVX2__)
+    computeFieldBatchAVX2(cx, cy, cq, count, xs, ys, n, ex, ey, cutoff2);
+#elif defined(__SSE2__) || defined(_M_X64)
+    computeFieldBatchSSE(cx, cy, cq, count, xs, ys, n, ex, ey, cutoff2);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    computeFieldBatchNEON(cx, cy, cq, count, xs, ys, n, ex, ey, cutoff2);
+#else
+    computeFieldBatchScalar(cx, cy, cq, count, xs, ys, n, ex, ey, cutoff2);
+#endif
+}
+
+const char* fieldKernelName() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "sse";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void applyChargeDelta(float oldX, float oldY, float oldQ, float newX, float newY, float newQ,
+                      const float* xs, const float* ys, size_t n,
+                      float* ex, float* ey, float cutoff2) {
+    // Branch-free body so the compiler can vectorise it on its own
+    for (size_t t = 0; t < n; t++) {
+        float oldRx = xs[t] - oldX;
+        float oldRy = ys[t] - oldY;
+        float oldD2 = oldRx*oldRx + oldRy*oldRy;
+        float oldInv = oldD2 >= cutoff2 ? 1.0f / std::sqrt(oldD2) : 0.0f;
+        float oldScale = oldQ * oldInv * oldInv * oldInv;
+
+        float newRx = xs[t] - newX;
+        float newRy = ys[t] - newY;
+        float newD2 = newRx*newRx + newRy*newRy;
+        float newInv = newD2 >= cutoff2 ? 1.0f / std::sqrt(newD2) : 0.0f;
+        float newScale = newQ * newInv * newInv * newInv;
+
+        ex[t] += newScale * newRx - oldScale * oldRx;
+        ey[t] += newScale * newRy - oldScale * oldRy;
+    }
+}
+
+void computePotentialBatch(const float* cx, const float* cy, const float* cq, size_t count,
+                           const float* xs, const float* ys, size_t n,
+                           float* potential, float minDist2) {
+    for (size_t t = 0; t < n; t++) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            float rx = xs[t] - cx[i];
+            float ry = ys[t] - cy[i];
+            float distSquared = std::max(rx*rx + ry*ry, minDist2);
+            sum += cq[i] / std::sqrt(distSquared);
+        }
+        potential[t] = sum;
+    }
+}
+
+void applyPotentialDelta(float oldX, float oldY, float oldQ, float newX, float newY, float newQ,
+                         const float* xs, const float* ys, size_t n,
+                         float* potential, float minDist2) {
+    for (size_t t = 0; t < n; t++) {
+        float oldRx = xs[t] - oldX;
+        float oldRy = ys[t] - oldY;
+        float newRx = xs[t] - newX;
+        float newRy = ys[t] - newY;
+        float oldD2 = std::max(oldRx*oldRx + oldRy*oldRy, minDist2);
+        float newD2 = std::max(newRx*newRx + newRy*newRy, minDist2);
+        potential[t] += newQ / std::sqrt(newD2) - oldQ / std::sqrt(oldD2);
+    }
+}
+
+void computeSoftenedFieldBatch(const float* cx, const float* cy, const float* cq, size_t count,
+                               const float* xs, const float* ys, size_t n,
+                               float* ex, float* ey, float softening2) {
+    for (size_t t = 0; t < n; t++) {
+        float sumX = 0.0f;
+        float sumY = 0.0f;
+
+        for (size_t i = 0; i < count; i++) {
+            float rx = xs[t] - cx[i];
+            float ry = ys[t] - cy[i];
+            float distSquared = rx*rx + ry*ry;
+            float invDist = distSquared > 0.0f ? 1.0f / std::sqrt(distSquared + softening2) : 0.0f;
+            float scale = cq[i] * invDist * invDist * invDist;
+            sumX += scale * rx;
+            sumY += scale * ry;
+        }
+
+        ex[t] = sumX;
+        ey[t] = sumY;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+
+// Batch direct-sum kernels for the electric field.
+// Charges are passed as structure-of-arrays (cx, cy, cq) and the field is
+// evaluated at n targets (xs, ys) using the E = q * r / |r|^3 form, so no
+// per-charge normalize is needed. Contributions from charges closer than
+// sqrt(cutoff2) to a target are skipped, like ElectricField::getFieldAt.
+
+// Picks the widest kernel available for the target we were built for
+void computeFieldBatch(const float* cx, const float* cy, const float* cq, size_t count,
+                       const float* xs, const float* ys, size_t n,
+                       float* ex, float* ey, float cutoff2);
+
+// Plain C++ version, also used for the tails of the SIMD kernels
+void computeFieldBatchScalar(const float* cx, const float* cy, const float* cq, size_t count,
+                             const float* xs, const float* ys, size_t n,
+                             float* ex, float* ey, float cutoff2);
+
+// Name of the kernel computeFieldBatch dispatches to ("avx2", "sse", "neon", "scalar")
+const char* fieldKernelName();
+
+// Adds the field of one charge at (newX, newY, newQ) and removes the field it
+// had at (oldX, oldY, oldQ), in place on ex/ey. Same cutoff rule as above.
+void applyChargeDelta(float oldX, float oldY, float oldQ, float newX, float newY, float newQ,
+                      const float* xs, const float* ys, size_t n,
+                      float* ex, float* ey, float cutoff2);
+
+// Potential q / |r| of the charges at n targets. Distances below
+// sqrt(minDist2) are clamped rather than skipped, so the potential stays
+// continuous around the charges (contouring relies on that).
+void computePotentialBatch(const float* cx, const float* cy, const float* cq, size_t count,
+                           const float* xs, const float* ys, size_t n,
+                           float* potential, float minDist2);
+
+// Potential counterpart of applyChargeDelta
+void applyPotentialDelta(float oldX, float oldY, float oldQ, float newX, float newY, float newQ,
+                         const float* xs, const float* ys, size_t n,
+                         float* potential, float minDist2);
+
+// Plummer-softened field q * r / (|r|^2 + softening2)^(3/2) of the charges
+// at n targets, used for the forces between charges. Pairs at exactly the
+// same point (a charge and itself) contribute nothing.
+void computeSoftenedFieldBatch(const float* cx, const float* cy, const float* cq, size_t count,
+                               const float* xs, const float* ys, size_t n,
+                               float* ex, float* ey, float softening2);
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FieldLines.hpp"
+#include "TaskScheduler.hpp"
+
+namespace {
+    const float seedRadius = 0.12f;    // Just outside the 0.1 field cutoff
+    const float stopRadius = 0.1f;     // Closer than this to a charge ends a line
+    const float minStep = 1e-4f;
+    const float maxStep = 0.05f;       // Also keeps the strips smooth to look at
+    const int maxVertices = 2000;
+    const float viewMargin = 0.1f;     // Lines may leave the view by this much
+
+    // Dormand-Prince 5(4) tableau; the 5th order weights are the last row
+    // of a, so the final stage doubles as the first stage of the next step
+    const float a21 = 1.0f / 5.0f;
+    const float a31 = 3.0f / 40.0f, a32 = 9.0f / 40.0f;
+    const float a41 = 44.0f / 45.0f, a42 = -56.0f / 15.0f, a43 = 32.0f / 9.0f;
+    const float a51 = 19372.0f / 6561.0f, a52 = -25360.0f / 2187.0f, a53 = 64448.0f / 6561.0f,
+                a54 = -212.0f / 729.0f;
+    const float a61 = 9017.0f / 3168.0f, a62 = -355.0f / 33.0f, a63 = 46732.0f / 5247.0f,
+                a64 = 49.0f / 176.0f, a65 = -5103.0f / 18656.0f;
+    const float b1 = 35.0f / 384.0f, b3 = 500.0f / 1113.0f, b4 = 125.0f / 192.0f,
+                b5 = -2187.0f / 6784.0f, b6 = 11.0f / 84.0f;
+    // 5th minus 4th order weights, for the error estimate
+    const float e1 = 71.0f / 57600.0f, e3 = -71.0f / 16695.0f, e4 = 71.0f / 1920.0f,
+                e5 = -17253.0f / 339200.0f, e6 = 22.0f / 525.0f, e7 = -1.0f / 40.0f;
+}
+
+void FieldLines::setBounds(float newXMin, float newXMax, float newYMin, float newYMax) {
+    if (newXMin == xMin && newXMax == xMax && newYMin == yMin && newYMax == yMax) return;
+    xMin = newXMin;
+    xMax = newXMax;
+    yMin = newYMin;
+    yMax = newYMax;
+    valid = false;
+}
+
+void FieldLines::setLinesPerCharge(float lines) {
+    linesPerCharge = std::max(lines, 0.0f);
+    valid = false;
+}
+
+void FieldLines::setTolerance(float newTolerance) {
+    newTolerance = std::max(newTolerance, 1e-7f);
+    if (newTolerance == tolerance) return;
+    tolerance = newTolerance;
+    valid = false;
+}
+
+void FieldLines::update(const ElectricField& field) {
+    if (valid && fieldRevision == field.getRevision()) return;
+
+    const ChargeStorage& charges = field.getChargeStorage();
+
+    seeds.clear();
+    for (size_t i = 0; i < charges.size(); i++) {
+        float q = charges.q[i];
+        if (q == 0.0f) continue;
+
+        int count = std::max(1, static_cast<int>(std::lround(linesPerCharge * std::fabs(q))));
+        for (int k = 0; k < count; k++) {
+            float angle = 2.0f * static_cast<float>(M_PI) * k / count;
+            seeds.push_back(Seed{charges.x[i] + seedRadius * std::cos(angle),
+                                 charges.y[i] + seedRadius * std::sin(angle),
+                                 q > 0.0f ? 1.0f : -1.0f, static_cast<int>(i)});
+        }
+    }
+
+    lines.resize(seeds.size());
+    TaskScheduler::global().parallelFor(0, seeds.size(), 4, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            lines[s].clear();
+            trace(field, seeds[s], lines[s]);
+        }
+    });
+
+    vertices.clear();
+    firsts.clear();
+    counts.clear();
+    for (const auto& line : lines) {
+        if (line.size() < 4) continue;
+        firsts.push_back(static_cast<int>(vertices.size() / 2));
+        counts.push_back(static_cast<int>(line.size() / 2));
+        vertices.insert(vertices.end(), line.begin(), line.end());
+    }
+
+    valid = true;
+    fieldRevision = field.getRevision();
+    version++;
+}
+
+void FieldLines::trace(const ElectricField& field, const Seed& seed, std::vector<float>& out) const {
+    const ChargeStorage& charges = field.getChargeStorage();
+
+    // Unit tangent of the line; false at a null point
+    auto direction = [&](float x, float y, glm::vec2& d) {
+        glm::vec2 e = field.getFieldAt(x, y);
+        float magnitude = glm::length(e);
+        if (!(magnitude > 1e-6f)) return false;
+        d = e * (seed.direction / magnitude);
+        return true;
+    };
+
+    float x = seed.x;
+    float y = seed.y;
+    out.push_back(x);
+    out.push_back(y);
+
+    glm::vec2 k1;
+    if (!direction(x, y, k1)) return;
+
+    float h = 0.01f;
+    while (static_cast<int>(out.size() / 2) < maxVertices) {
+        glm::vec2 k2, k3, k4, k5, k6, k7;
+        glm::vec2 p;
+        bool ok = true;
+
+        p = glm::vec2(x, y) + h * (a21 * k1);
+        ok = ok && direction(p.x, p.y, k2);
+        p = glm::vec2(x, y) + h * (a31 * k1 + a32 * k2);
+        ok = ok && direction(p.x, p.y, k3);
+        p = glm::vec2(x, y) + h * (a41 * k1 + a42 * k2 + a43 * k3);
+        ok = ok && direction(p.x, p.y, k4);
+        p = glm::vec2(x, y) + h * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4);
+        ok = ok && direction(p.x, p.y, k5);
+        p = glm::vec2(x, y) + h * (a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5);
+        ok = ok && direction(p.x, p.y, k6);
+        glm::vec2 next = glm::vec2(x, y) + h * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6);
+        ok = ok && direction(next.x, next.y, k7);
+
+        if (!ok) {
+            // Stepped onto a null point; retry smaller or give up there
+            if (h <= minStep) return;
+            h = std::max(h * 0.25f, minStep);
+            continue;
+        }
+
+        glm::vec2 errorVector = h * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7);
+        float error = glm::length(errorVector);
+
+        // Usual controller: aim for the tolerance, grow at most 5x, shrink at most 5x
+        float factor = error > 0.0f ? 0.9f * std::pow(tolerance / error, 0.2f) : 5.0f;
+        factor = std::min(5.0f, std::max(0.2f, factor));
+
+        if (error > tolerance && h > minStep) {
+            h = std::max(h * factor, minStep);
+            continue;
+        }
+
+        x = next.x;
+        y = next.y;
+        k1 = k7;
+        h = std::min(std::max(h * factor, minStep), maxStep);
+
+        // Reached a charge: end the line on its centre. The field's index
+        // only looks at the nearby cells, not at every charge.
+        int reached = field.findChargeAt(x, y, stopRadius, seed.charge);
+        if (reached >= 0) {
+            out.push_back(charges.x[reached]);
+            out.push_back(charges.y[reached]);
+            return;
+        }
+
+        out.push_back(x);
+        out.push_back(y);
+
+        if (x < xMin - viewMargin || x > xMax + viewMargin ||
+            y < yMin - viewMargin || y > yMax + viewMargin) return;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ElectricField.hpp"
+
+// Field lines traced by integrating dx/ds = E/|E| with adaptive
+// Dormand-Prince (RK45) steps, so the step shrinks where the field bends
+// near charges and grows in the smooth regions in between.
+// Lines start evenly spaced on a small circle around each charge, as many
+// as linesPerCharge * |q|, and go away from the charge (along E for
+// positive charges, against it for negative ones). A line stops when it
+// reaches another charge, leaves the view, hits a null point or runs out
+// of steps. Seeds are traced in parallel and the result is one vertex
+// list holding every line as a line strip (first/count per line).
+class FieldLines {
+public:
+    // Region lines are traced in; a new region invalidates the lines
+    void setBounds(float xMin, float xMax, float yMin, float yMax);
+
+    // Lines per unit of |q| (at least one line per charge)
+    void setLinesPerCharge(float lines);
+    float getLinesPerCharge() const { return linesPerCharge; }
+
+    // Local error allowed per step, in world units
+    void setTolerance(float tolerance);
+
+    // Re-traces the lines if the field or the settings changed
+    void update(const ElectricField& field);
+
+    // x, y pairs of all lines back to back
+    const std::vector<float>& getVertices() const { return vertices; }
+    // First vertex and vertex count of each line strip
+    const std::vector<int>& getFirsts() const { return firsts; }
+    const std::vector<int>& getCounts() const { return counts; }
+
+    // Bumped whenever the vertices change (to know when to re-upload them)
+    uint64_t getVersion() const { return version; }
+
+private:
+    struct Seed {
+        float x, y;
+        float direction;    // +1 along E, -1 against it
+        int charge;         // Charge the line starts from
+    };
+
+    float xMin = -1.0f, xMax = 1.0f, yMin = -1.0f, yMax = 1.0f;
+    float linesPerCharge = 8.0f;
+    float tolerance = 1e-4f;
+
+    std::vector<Seed> seeds;
+    std::vector<std::vector<float>> lines;   // Per-seed output, merged in order
+    std::vector<float> vertices;
+    std::vector<int> firsts, counts;
+
+    bool valid = false;
+    uint64_t fieldRevision = 0;
+    uint64_t version = 0;
+
+    void trace(const ElectricField& field, const Seed& seed, std::vector<float>& out) const;
+};
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include "FrameArena.hpp"
+
+namespace {
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+FrameArena::FrameArena(size_t initialCapacity)
+    : block(static_cast<char*>(std::malloc(std::max<size_t>(initialCapacity, 64)))),
+      capacity(std::max<size_t>(initialCapacity, 64)) {}
+
+FrameArena::~FrameArena() {
+    reset();
+    std::free(block);
+}
+
+FrameArena& FrameArena::frame() {
+    static FrameArena arena;
+    return arena;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    // malloc'd blocks are max_align_t aligned, so offsets are enough
+    size_t offset = alignUp(used, alignment);
+    if (offset + bytes <= capacity) {
+        used = offset + bytes;
+        return block + offset;
+    }
+
+    // Does not fit this frame; counted so the next reset makes room
+    void* memory = std::malloc(std::max<size_t>(bytes, 1));
+    overflow.push_back(memory);
+    overflowBytes += bytes + alignment;
+    return memory;
+}
+
+std::string_view FrameArena::format(const char* pattern, ...) {
+    va_list arguments;
+    va_start(arguments, pattern);
+    va_list retry;
+    va_copy(retry, arguments);
+
+    // Try the rest of the block first; most labels fit
+    size_t available = capacity > used ? capacity - used : 0;
+    char* out = block + used;
+    int length = std::vsnprintf(out, available, pattern, arguments);
+    va_end(arguments);
+
+    if (length < 0) {
+        va_end(retry);
+        return std::string_view();
+    }
+    if (static_cast<size_t>(length) < available) {
+        used += length + 1;
+    } else {
+        out = static_cast<char*>(allocate(length + 1, 1));
+        std::vsnprintf(out, length + 1, pattern, retry);
+    }
+    va_end(retry);
+    return std::string_view(out, length);
+}
+
+void FrameArena::reset() {
+    if (!overflow.empty()) {
+        for (void* memory : overflow) std::free(memory);
+        overflow.clear();
+
+        // Grow to this frame's total so the next one fits in the block
+        size_t needed = used + overflowBytes;
+        std::free(block);
+        capacity = alignUp(needed + needed / 4, 4096);
+        block = static_cast<char*>(std::malloc(capacity));
+    }
+    used = 0;
+    overflowBytes = 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame
+// (arrow lists, formatted labels). Allocating is a pointer bump and
+// reset() frees everything at once, so transient data never reaches the
+// general heap. When a frame needs more than the block holds, the extra
+// goes to overflow blocks and the next reset() grows the block to the
+// frame's high-water mark: after a few frames every frame fits and the
+// arena stops allocating altogether.
+// Not thread-safe; the render loop uses it from the main thread.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialCapacity = 256 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Memory valid until the next reset()
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // printf-style formatting into the arena; the text is null-terminated
+    // and valid until the next reset()
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    std::string_view format(const char* pattern, ...);
+
+    // Releases everything allocated since the last reset
+    void reset();
+
+    size_t getUsed() const { return used + overflowBytes; }
+    size_t getCapacity() const { return capacity; }
+
+    // Arena of the render loop, reset after every buffer swap
+    static FrameArena& frame();
+
+private:
+    char* block;
+    size_t capacity;
+    size_t used = 0;
+
+    // Allocations that did not fit in the block this frame
+    std::vector<void*> overflow;
+    size_t overflowBytes = 0;
+};
+
+// Standard allocator over a FrameArena; deallocate is a no-op, the memory
+// comes back at the next reset()
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    FrameArena* arena;
+};
+
+// Vector whose storage lives in a frame arena; reserve() up front, since
+// storage given up by growing is not reused until the reset
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
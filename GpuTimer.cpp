@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cstring>
+
+#include "GpuTimer.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    const uint64_t averagingWindow = 500000000;   // Same refresh as the CPU zones, ns
+}
+
+GpuTimer::~GpuTimer() {
+    for (QuerySet& set : sets) {
+        if (!set.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+        }
+    }
+}
+
+bool GpuTimer::collect(QuerySet& set) {
+    if (!set.pending) return true;
+
+    // Queries finish in order, so the last one being ready means all are
+    GLint available = 0;
+    glGetQueryObjectiv(set.queries[set.names.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    for (size_t i = 0; i < set.names.size(); i++) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(set.queries[i], GL_QUERY_RESULT, &nanoseconds);
+        double milliseconds = nanoseconds * 1e-6;
+
+        const char* name = set.names[i];
+        auto total = std::find_if(windowTotals.begin(), windowTotals.end(), [&](const PassTime& pass) {
+            return pass.name == name || std::strcmp(pass.name, name) == 0;
+        });
+        if (total == windowTotals.end()) {
+            windowTotals.push_back(PassTime{name, milliseconds});
+        } else {
+            total->milliseconds += milliseconds;
+        }
+    }
+
+    windowFrames++;
+    set.pending = false;
+    return true;
+}
+
+void GpuTimer::beginFrame() {
+    if (open) end();
+    if (current >= 0) sets[current].pending = !sets[current].names.empty();
+
+    // Read back oldest first; stop at the first set the GPU is still on
+    int next = (current + 1) % framesInFlight;
+    for (int k = 0; k < framesInFlight; k++) {
+        if (!collect(sets[(next + k) % framesInFlight])) break;
+    }
+
+    // The set we are about to reuse should have been read long ago
+    if (sets[next].pending) {
+        sets[next].pending = false;
+        droppedFrames++;
+    }
+    current = next;
+    sets[current].names.clear();
+
+    uint64_t time = Profiler::now();
+    if (time - windowStart >= averagingWindow) {
+        passTimes = windowTotals;
+        for (PassTime& pass : passTimes) pass.milliseconds /= std::max(windowFrames, 1);
+
+        for (PassTime& pass : windowTotals) pass.milliseconds = 0.0;
+        windowFrames = 0;
+        windowStart = time;
+    }
+}
+
+bool GpuTimer::begin(const char* name) {
+    if (current < 0 || open) return false;
+
+    QuerySet& set = sets[current];
+    if (set.names.size() == set.queries.size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        set.queries.push_back(query);
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, set.queries[set.names.size()]);
+    set.names.push_back(name);
+    open = true;
+    return true;
+}
+
+void GpuTimer::end() {
+    if (!open) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    open = false;
+}
+
+double GpuTimer::getMilliseconds(const char* name) const {
+    for (const PassTime& pass : passTimes) {
+        if (pass.name == name || std::strcmp(pass.name, name) == 0) return pass.milliseconds;
+    }
+    return -1.0;
+}
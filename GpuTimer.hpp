@@ -0,0 +1,80 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+// GPU time of named render passes, from GL_TIME_ELAPSED queries.
+// Each frame uses its own set of queries, and a set is only read back
+// framesInFlight frames later, when the GPU has long finished it, so the
+// readback never waits on the GPU. If a set is still not done by the time
+// it comes round again its results are dropped instead of stalling.
+// Elapsed-time queries cannot nest: a pass begun while another is open is
+// ignored (its time stays in the outer pass).
+class GpuTimer {
+public:
+    struct PassTime {
+        const char* name;
+        double milliseconds;
+    };
+
+    // Queries are created on first use, so only begin() needs a GL context
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Reads back the finished sets and starts this frame's set
+    void beginFrame();
+
+    // Times the GL commands between begin and end; name must be a literal.
+    // Returns false when the pass was ignored (another one is open).
+    bool begin(const char* name);
+    void end();
+
+    // Per-pass averages over the last averaging window, in ms per frame
+    const std::vector<PassTime>& getPassTimes() const { return passTimes; }
+
+    // Averaged time of one pass, or -1 if it has not been measured
+    double getMilliseconds(const char* name) const;
+
+    // Query sets thrown away because the GPU had not finished them
+    uint64_t getDroppedFrames() const { return droppedFrames; }
+
+private:
+    static const int framesInFlight = 4;
+
+    struct QuerySet {
+        std::vector<GLuint> queries;      // Grows to the most passes seen in a frame
+        std::vector<const char*> names;   // Pass of each used query
+        bool pending = false;             // Issued and not read back yet
+    };
+
+    QuerySet sets[framesInFlight];
+    int current = -1;
+    bool open = false;
+
+    // Pass sums of the current averaging window
+    std::vector<PassTime> windowTotals;
+    int windowFrames = 0;
+    uint64_t windowStart = 0;
+    std::vector<PassTime> passTimes;
+    uint64_t droppedFrames = 0;
+
+    // Adds the set's results to the window if they are available
+    bool collect(QuerySet& set);
+};
+
+// Times its own scope as a GPU pass
+class GpuZone {
+public:
+    GpuZone(GpuTimer& timer, const char* name) : timer(timer), started(timer.begin(name)) {}
+    ~GpuZone() { if (started) timer.end(); }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+private:
+    GpuTimer& timer;
+    bool started;
+};
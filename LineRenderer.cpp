@@ -0,0 +1,68 @@
+#include <glm/gtc/type_ptr.hpp>
+
+#include "LineRenderer.hpp"
+
+LineRenderer::LineRenderer() : vertexCount(0), capacity(0), uploadedVersion(0), uploaded(false) {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+LineRenderer::~LineRenderer() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+}
+
+void LineRenderer::upload(const std::vector<float>& vertices, uint64_t version) {
+    if (uploaded && version == uploadedVersion) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (vertices.size() > capacity) {
+        // Grow with some headroom so dragging does not reallocate every frame
+        capacity = vertices.size() + vertices.size() / 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    }
+    if (!vertices.empty()) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    vertexCount = static_cast<GLsizei>(vertices.size() / 2);
+    uploadedVersion = version;
+    uploaded = true;
+}
+
+void LineRenderer::useShader(GLuint shaderProgram, const glm::mat4& projection, const glm::vec3& color) const {
+    glm::mat4 identity = glm::mat4(1.0f);
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "color"), 1, glm::value_ptr(color));
+}
+
+void LineRenderer::draw(GLuint shaderProgram, const glm::mat4& projection, const glm::vec3& color) const {
+    if (vertexCount == 0) return;
+
+    useShader(shaderProgram, projection, color);
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_LINES, 0, vertexCount);
+    glBindVertexArray(0);
+}
+
+void LineRenderer::drawStrips(GLuint shaderProgram, const glm::mat4& projection, const glm::vec3& color,
+                              const std::vector<int>& firsts, const std::vector<int>& counts) const {
+    if (vertexCount == 0 || firsts.empty()) return;
+
+    useShader(shaderProgram, projection, color);
+    glBindVertexArray(VAO);
+    glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), static_cast<GLsizei>(firsts.size()));
+    glBindVertexArray(0);
+}
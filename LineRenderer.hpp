@@ -0,0 +1,36 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Draws 2D lines from a single VBO of x, y pairs, either as separate
+// segments or as a batch of line strips.
+// The vertices are only re-uploaded when their version changes, so cached
+// geometry (equipotentials, field lines) costs one draw call per frame.
+class LineRenderer {
+public:
+    LineRenderer();
+    ~LineRenderer();
+
+    // Uploads the vertices unless this version is already in the buffer
+    void upload(const std::vector<float>& vertices, uint64_t version);
+
+    // Draws the segments with a shader that has model/view/projection and
+    // color uniforms (the sensor shader)
+    void draw(GLuint shaderProgram, const glm::mat4& projection, const glm::vec3& color) const;
+
+    // Draws the vertices as line strips (first vertex and vertex count per
+    // strip) with one glMultiDrawArrays call
+    void drawStrips(GLuint shaderProgram, const glm::mat4& projection, const glm::vec3& color,
+                    const std::vector<int>& firsts, const std::vector<int>& counts) const;
+
+private:
+    GLuint VAO, VBO;
+    GLsizei vertexCount;
+    size_t capacity;              // Buffer size in floats
+    uint64_t uploadedVersion;
+    bool uploaded;
+
+    void useShader(GLuint shaderProgram, const glm::mat4& projection, const glm::vec3& color) const;
+};
@@ -0,0 +1,157 @@
+#include <iostream>
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::openRead(const std::string& path) {
+    return map(path, 0, false);
+}
+
+bool MappedFile::create(const std::string& path, uint64_t size) {
+    if (size == 0) {
+        std::cerr << "Cannot map an empty file: " << path << std::endl;
+        return false;
+    }
+    return map(path, size, true);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const std::string& path, uint64_t size, bool write) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, write ? CREATE_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Could not open " << path << " (error " << GetLastError() << ")" << std::endl;
+        return false;
+    }
+    fileHandle = file;
+
+    if (write) {
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            std::cerr << "Could not resize " << path << " (error " << GetLastError() << ")" << std::endl;
+            close();
+            return false;
+        }
+    } else {
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            std::cerr << "Cannot map an empty file: " << path << std::endl;
+            close();
+            return false;
+        }
+        size = static_cast<uint64_t>(fileSize.QuadPart);
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, write ? PAGE_READWRITE : PAGE_READONLY,
+                                        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (!mapping) {
+        std::cerr << "Could not map " << path << " (error " << GetLastError() << ")" << std::endl;
+        close();
+        return false;
+    }
+    mappingHandle = mapping;
+
+    address = MapViewOfFile(mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!address) {
+        std::cerr << "Could not map " << path << " (error " << GetLastError() << ")" << std::endl;
+        close();
+        return false;
+    }
+    length = size;
+    writable = write;
+    return true;
+}
+
+bool MappedFile::flush() {
+    if (!address || !writable) return true;
+    return FlushViewOfFile(address, 0) && FlushFileBuffers(static_cast<HANDLE>(fileHandle));
+}
+
+void MappedFile::close() {
+    if (address) UnmapViewOfFile(address);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    address = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    length = 0;
+    writable = false;
+}
+
+#else
+
+bool MappedFile::map(const std::string& path, uint64_t size, bool write) {
+    close();
+
+    descriptor = write ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+                       : ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        std::cerr << "Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (write) {
+        // Extending with ftruncate leaves a sparse file: no disk used until written
+        if (::ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+            std::cerr << "Could not resize " << path << ": " << std::strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+    } else {
+        struct stat info;
+        if (::fstat(descriptor, &info) != 0 || info.st_size == 0) {
+            std::cerr << "Cannot map an empty file: " << path << std::endl;
+            close();
+            return false;
+        }
+        size = static_cast<uint64_t>(info.st_size);
+    }
+
+    void* mapped = ::mmap(nullptr, size, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Could not map " << path << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    address = mapped;
+    length = size;
+    writable = write;
+    return true;
+}
+
+bool MappedFile::flush() {
+    if (!address || !writable) return true;
+    return ::msync(address, length, MS_SYNC) == 0;
+}
+
+void MappedFile::close() {
+    if (address) ::munmap(address, length);
+    if (descriptor >= 0) ::close(descriptor);
+    address = nullptr;
+    descriptor = -1;
+    length = 0;
+    writable = false;
+}
+
+#endif
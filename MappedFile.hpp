@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// A whole file mapped into memory (mmap, or a file mapping on Windows).
+// Pages are read in on first touch and written back by the OS, so files far
+// larger than RAM can be used as if they were in memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps an existing file read-only
+    bool openRead(const std::string& path);
+
+    // Creates (or truncates) a file of `size` bytes and maps it read-write;
+    // untouched bytes read as zero
+    bool create(const std::string& path, uint64_t size);
+
+    // Writes dirty pages back to the file
+    bool flush();
+
+    void close();
+
+    bool isOpen() const { return address != nullptr; }
+    const uint8_t* getData() const { return static_cast<const uint8_t*>(address); }
+    uint8_t* getWritableData() { return writable ? static_cast<uint8_t*>(address) : nullptr; }
+    uint64_t getSize() const { return length; }
+
+private:
+    void* address = nullptr;
+    uint64_t length = 0;
+    bool writable = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int descriptor = -1;
+#endif
+
+    bool map(const std::string& path, uint64_t size, bool write);
+};
@@ -2,6 +2,7 @@
 #include <stack>
 
 #include "Menu.hpp"
+#include "Profiler.hpp"
 
 Menu::Menu(TextRender* textRenderer, GLFWwindow* window)
     : textRenderer(textRenderer), window(window), visible(false), lastMouseX(0), lastMouseY(0) {
@@ -137,6 +138,7 @@ void Menu::switchOptionUp(int button, int action) {
 
 void Menu::render() {
     if (!visible) return;
+    PROFILE_ZONE("Menu::render");
     
     for (const auto& item : items) {
         glm::vec3 color = item.isHovered ? item.hoverColor : item.normalColor;
@@ -0,0 +1,152 @@
+#include <cmath>
+
+#include "PreciseFieldKernels.hpp"
+
+namespace {
+    // 1/|r|^3 of one charge for each softening mode, in the working type T
+
+    template <typename T>
+    struct HardCutoffTerm {
+        static T inverseCube(T d2, T eps2) {
+            if (d2 < eps2) return T(0);
+            T invDist = T(1) / std::sqrt(d2);
+            return invDist * invDist * invDist;
+        }
+    };
+
+    template <typename T>
+    struct PlummerTerm {
+        static T inverseCube(T d2, T eps2) {
+            T invDist = T(1) / std::sqrt(d2 + eps2);
+            return invDist * invDist * invDist;
+        }
+    };
+
+    template <typename T>
+    struct PlainTerm {
+        static T inverseCube(T d2, T) {
+            if (d2 == T(0)) return T(0);    // Query on the charge
+            T invDist = T(1) / std::sqrt(d2);
+            return invDist * invDist * invDist;
+        }
+    };
+
+    // Neumaier's variant of Kahan summation: also exact when the new term
+    // is larger than the running sum
+    struct CompensatedSum {
+        float sum = 0.0f;
+        float compensation = 0.0f;
+
+        void add(float term) {
+            // Selects instead of a branch: the comparison is unpredictable
+            float total = sum + term;
+            bool sumLarger = std::fabs(sum) >= std::fabs(term);
+            float larger = sumLarger ? sum : term;
+            float smaller = sumLarger ? term : sum;
+            compensation += (larger - total) + smaller;
+            sum = total;
+        }
+
+        float value() const { return sum + compensation; }
+    };
+
+    template <template <typename> class Term>
+    void fieldCompensated(const float* cx, const float* cy, const float* cq, size_t count,
+                          const float* xs, const float* ys, size_t n,
+                          float* ex, float* ey, float eps2) {
+        for (size_t t = 0; t < n; t++) {
+            CompensatedSum sumX, sumY;
+            for (size_t i = 0; i < count; i++) {
+                float rx = xs[t] - cx[i];
+                float ry = ys[t] - cy[i];
+                float scale = cq[i] * Term<float>::inverseCube(rx*rx + ry*ry, eps2);
+                sumX.add(scale * rx);
+                sumY.add(scale * ry);
+            }
+            ex[t] = sumX.value();
+            ey[t] = sumY.value();
+        }
+    }
+
+    template <template <typename> class Term>
+    void fieldDouble(const float* cx, const float* cy, const float* cq, size_t count,
+                     const float* xs, const float* ys, size_t n,
+                     float* ex, float* ey, float eps2) {
+        for (size_t t = 0; t < n; t++) {
+            double sumX = 0.0;
+            double sumY = 0.0;
+            for (size_t i = 0; i < count; i++) {
+                double rx = static_cast<double>(xs[t]) - cx[i];
+                double ry = static_cast<double>(ys[t]) - cy[i];
+                double scale = cq[i] * Term<double>::inverseCube(rx*rx + ry*ry, eps2);
+                sumX += scale * rx;
+                sumY += scale * ry;
+            }
+            ex[t] = static_cast<float>(sumX);
+            ey[t] = static_cast<float>(sumY);
+        }
+    }
+
+    template <template <typename> class Term>
+    void fieldFloat(const float* cx, const float* cy, const float* cq, size_t count,
+                    const float* xs, const float* ys, size_t n,
+                    float* ex, float* ey, float eps2) {
+        for (size_t t = 0; t < n; t++) {
+            float sumX = 0.0f;
+            float sumY = 0.0f;
+            for (size_t i = 0; i < count; i++) {
+                float rx = xs[t] - cx[i];
+                float ry = ys[t] - cy[i];
+                float scale = cq[i] * Term<float>::inverseCube(rx*rx + ry*ry, eps2);
+                sumX += scale * rx;
+                sumY += scale * ry;
+            }
+            ex[t] = sumX;
+            ey[t] = sumY;
+        }
+    }
+
+    template <template <typename> class Term>
+    void fieldWithPrecision(FieldPrecision precision,
+                            const float* cx, const float* cy, const float* cq, size_t count,
+                            const float* xs, const float* ys, size_t n,
+                            float* ex, float* ey, float eps2) {
+        switch (precision) {
+            case FieldPrecision::Float:
+                fieldFloat<Term>(cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+                break;
+            case FieldPrecision::Compensated:
+                fieldCompensated<Term>(cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+                break;
+            case FieldPrecision::Double:
+                fieldDouble<Term>(cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+                break;
+        }
+    }
+}
+
+void computeFieldBatchPrecise(FieldPrecision precision, SofteningMode mode,
+                              const float* cx, const float* cy, const float* cq, size_t count,
+                              const float* xs, const float* ys, size_t n,
+                              float* ex, float* ey, float eps2) {
+    switch (mode) {
+        case SofteningMode::HardCutoff:
+            fieldWithPrecision<HardCutoffTerm>(precision, cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+            break;
+        case SofteningMode::Plummer:
+            fieldWithPrecision<PlummerTerm>(precision, cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+            break;
+        case SofteningMode::None:
+            fieldWithPrecision<PlainTerm>(precision, cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+            break;
+    }
+}
+
+const char* fieldPrecisionName(FieldPrecision precision) {
+    switch (precision) {
+        case FieldPrecision::Float: return "float";
+        case FieldPrecision::Compensated: return "compensated";
+        case FieldPrecision::Double: return "double";
+    }
+    return "unknown";
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+#include "SmallFieldKernels.hpp"
+
+// How the direct sum accumulates the contributions of the charges.
+// With many charges of both signs the terms mostly cancel and a plain
+// float sum keeps little more than its rounding error; the slower modes
+// keep the cancellation exact enough for readouts such as the sensor.
+// Compensation only removes the error of the sum, not the rounding of each
+// float term, so Double is the one to use when accuracy matters and the
+// query count is small (on 40k charges in tight dipoles: float 4e-6,
+// compensated 2e-6, double 3e-8 relative error).
+enum class FieldPrecision {
+    Float,        // Plain float +=, the fast (SIMD) path
+    Compensated,  // Float terms, Neumaier-compensated sum, scalar
+    Double        // Terms and sum in double, scalar
+};
+
+// Direct sum of the field at n targets with the given accumulation and
+// softening (eps2 is the cutoff or softening radius squared)
+void computeFieldBatchPrecise(FieldPrecision precision, SofteningMode mode,
+                              const float* cx, const float* cy, const float* cq, size_t count,
+                              const float* xs, const float* ys, size_t n,
+                              float* ex, float* ey, float eps2);
+
+// Human readable name of a precision mode ("float", "compensated", "double")
+const char* fieldPrecisionName(FieldPrecision precision);
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "Profiler.hpp"
+
+namespace {
+    const size_t maxHistory = 1 << 18;            // Zones kept for the trace export
+    const uint64_t averagingWindow = 500000000;   // Overlay refresh, ns
+
+    thread_local void* currentBuffer = nullptr;
+}
+
+Profiler& Profiler::global() {
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+    if (!currentBuffer) {
+        // First zone on this thread: the only time recording takes a lock
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffers.back()->thread = static_cast<int>(buffers.size() - 1);
+        currentBuffer = buffers.back().get();
+    }
+    return *static_cast<ThreadBuffer*>(currentBuffer);
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = threadBuffer();
+
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    uint64_t tail = buffer.tail.load(std::memory_order_acquire);
+    if (head - tail >= ThreadBuffer::capacity) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.events[head & (ThreadBuffer::capacity - 1)] = Event{name, start, end};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::endFrame() {
+    // Allocated once up front so steady frames do not allocate
+    if (history.capacity() < maxHistory) history.reserve(maxHistory);
+
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto& buffer : buffers) {
+            uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+            for (uint64_t i = tail; i < head; i++) {
+                const Event& event = buffer->events[i & (ThreadBuffer::capacity - 1)];
+                double milliseconds = (event.end - event.start) * 1e-6;
+
+                auto total = std::find_if(windowTotals.begin(), windowTotals.end(), [&](const ZoneTime& zone) {
+                    return zone.name == event.name || std::strcmp(zone.name, event.name) == 0;
+                });
+                if (total == windowTotals.end()) {
+                    windowTotals.push_back(ZoneTime{event.name, milliseconds});
+                } else {
+                    total->milliseconds += milliseconds;
+                }
+
+                TraceEvent traced{event.name, event.start, event.end, buffer->thread};
+                if (history.size() < maxHistory) {
+                    history.push_back(traced);
+                } else {
+                    history[historyNext] = traced;
+                }
+                historyNext = (historyNext + 1) % maxHistory;
+            }
+            buffer->tail.store(head, std::memory_order_release);
+        }
+    }
+
+    // Publish the averages every window so the overlay stays readable
+    windowFrames++;
+    uint64_t time = now();
+    if (time - windowStart >= averagingWindow) {
+        zoneTimes = windowTotals;
+        for (ZoneTime& zone : zoneTimes) zone.milliseconds /= windowFrames;
+        std::sort(zoneTimes.begin(), zoneTimes.end(), [](const ZoneTime& a, const ZoneTime& b) {
+            return a.milliseconds > b.milliseconds;
+        });
+
+        for (ZoneTime& zone : windowTotals) zone.milliseconds = 0.0;
+        windowFrames = 0;
+        windowStart = time;
+    }
+}
+
+uint64_t Profiler::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : buffers) dropped += buffer->dropped.load(std::memory_order_relaxed);
+    return dropped;
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) return false;
+
+    // Complete ("X") events; timestamps and durations are in microseconds
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", out);
+    // Oldest first: once the ring is full the oldest sits at historyNext
+    size_t first = history.size() < maxHistory ? 0 : historyNext;
+    for (size_t i = 0; i < history.size(); i++) {
+        const TraceEvent& event = history[(first + i) % history.size()];
+        std::fprintf(out, "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}%s\n",
+                     event.name, event.thread, event.start * 1e-3, (event.end - event.start) * 1e-3,
+                     i + 1 < history.size() ? "," : "");
+    }
+    std::fputs("]}\n", out);
+
+    return std::fclose(out) == 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped CPU timing zones.
+// A zone records (name, start, end) when it goes out of scope into a ring
+// buffer owned by the current thread. Each ring has one writer (its thread)
+// and one reader (endFrame on the main thread), so recording is two atomic
+// stores and no lock; when a ring is full new zones are dropped rather than
+// blocking. Once per frame endFrame() drains every ring into the per-zone
+// averages shown by the overlay and into a bounded history that can be
+// written out as a Chrome trace (chrome://tracing, Perfetto).
+//
+// Zone names must be string literals (only the pointer is stored).
+
+class Profiler {
+public:
+    // Inclusive time of one zone name, averaged per frame
+    struct ZoneTime {
+        const char* name;
+        double milliseconds;
+    };
+
+    static Profiler& global();
+
+    // Nanoseconds on a steady clock
+    static uint64_t now();
+
+    // Called by ProfileZone; safe from any thread
+    void record(const char* name, uint64_t start, uint64_t end);
+
+    // Drains the thread rings; call once per frame from one thread
+    void endFrame();
+
+    // Per-zone averages over the last averaging window, slowest first
+    const std::vector<ZoneTime>& getZoneTimes() const { return zoneTimes; }
+
+    // Zones lost to full rings so far
+    uint64_t getDroppedCount() const;
+
+    // Writes the recent history as Chrome trace_event JSON
+    bool exportChromeTrace(const std::string& path) const;
+
+private:
+    struct Event {
+        const char* name;
+        uint64_t start, end;
+    };
+
+    struct TraceEvent {
+        const char* name;
+        uint64_t start, end;
+        int thread;
+    };
+
+    // Single-producer single-consumer ring of one thread's zones
+    struct ThreadBuffer {
+        static const size_t capacity = 1 << 14;   // Power of two
+        Event events[capacity];
+        std::atomic<uint64_t> head{0};            // Next slot to write (producer)
+        std::atomic<uint64_t> tail{0};            // Next slot to read (consumer)
+        std::atomic<uint64_t> dropped{0};
+        int thread = 0;
+    };
+
+    // Rings are never freed, so a thread may exit at any time
+    mutable std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    // Recent zones for the trace export, a ring that overwrites the oldest
+    std::vector<TraceEvent> history;
+    size_t historyNext = 0;
+
+    // Zone sums of the current averaging window
+    std::vector<ZoneTime> windowTotals;
+    int windowFrames = 0;
+    uint64_t windowStart = 0;
+    std::vector<ZoneTime> zoneTimes;
+
+    ThreadBuffer& threadBuffer();
+};
+
+#ifdef EFIELD_TRACK_ALLOCATIONS
+// Innermost zone of the calling thread, for the allocation tracker
+extern thread_local const char* currentProfileZone;
+#endif
+
+// Times its own scope
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), start(Profiler::now()) {
+#ifdef EFIELD_TRACK_ALLOCATIONS
+        parent = currentProfileZone;
+        currentProfileZone = name;
+#endif
+    }
+    ~ProfileZone() {
+#ifdef EFIELD_TRACK_ALLOCATIONS
+        currentProfileZone = parent;
+#endif
+        Profiler::global().record(name, start, Profiler::now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+#ifdef EFIELD_TRACK_ALLOCATIONS
+    const char* parent;
+#endif
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// PROFILE_ZONE("Name") times the rest of the enclosing scope. Building with
+// EFIELD_DISABLE_PROFILER compiles the zones out.
+#ifdef EFIELD_DISABLE_PROFILER
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
@@ -0,0 +1,334 @@
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "SceneIO.hpp"
+#include "ElectricField.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+    const char sceneMagic[8] = {'E', 'F', 'S', 'C', 'E', 'N', 'E', '\0'};
+    const uint32_t sceneVersion = 2;            // 1: charges only; 2: adds the sources
+    const uint32_t byteOrderMark = 0x01020304;   // Reads differently on the other endianness
+    const size_t headerBytes = 64;
+
+    struct SceneHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t count;
+        uint32_t flags;             // Zero in older files
+        uint32_t lineCount, arcCount, diskCount;      // Version 2 on
+        uint32_t polygonCount, polygonVertexCount;
+        uint8_t reserved[headerBytes - 48];
+    };
+    const uint32_t hasMassFlag = 1;     // A mass array follows q
+
+    const size_t lineFloats = 5, arcFloats = 6, diskFloats = 4;
+
+    // Replaces the field's sources; added one by one so their version keeps
+    // increasing and renderers notice the change
+    void replaceSources(ElectricField& field, const ContinuousSources& sources) {
+        field.clearSources();
+        for (const LineSource& line : sources.getLines()) field.addLineSource(line.start, line.end, line.charge);
+        for (const ArcSource& arc : sources.getArcs()) {
+            field.addArcSource(arc.center, arc.radius, arc.startAngle, arc.endAngle, arc.charge);
+        }
+        for (const DiskSource& disk : sources.getDisks()) field.addDiskSource(disk.center, disk.radius, disk.charge);
+        for (const PolygonSource& polygon : sources.getPolygons()) {
+            field.addPolygonSource(polygon.vertices, polygon.charge);
+        }
+    }
+
+    // Parses a source line of a text scene (keyword already read)
+    bool parseSource(const std::string& keyword, std::istringstream& fields, ContinuousSources& sources) {
+        if (keyword == "line") {
+            LineSource line;
+            if (!(fields >> line.start.x >> line.start.y >> line.end.x >> line.end.y >> line.charge)) return false;
+            sources.addLine(line);
+        } else if (keyword == "arc") {
+            ArcSource arc;
+            if (!(fields >> arc.center.x >> arc.center.y >> arc.radius >> arc.startAngle >> arc.endAngle >> arc.charge)) {
+                return false;
+            }
+            sources.addArc(arc);
+        } else if (keyword == "disk") {
+            DiskSource disk;
+            if (!(fields >> disk.center.x >> disk.center.y >> disk.radius >> disk.charge)) return false;
+            sources.addDisk(disk);
+        } else if (keyword == "polygon") {
+            PolygonSource polygon;
+            if (!(fields >> polygon.charge)) return false;
+            glm::vec2 vertex;
+            while (fields >> vertex.x) {
+                if (!(fields >> vertex.y)) return false;
+                polygon.vertices.push_back(vertex);
+            }
+            if (!fields.eof() || polygon.vertices.size() < 3) return false;   // Stopped on junk or too few
+            sources.addPolygon(polygon);
+        } else {
+            return false;
+        }
+        std::string extra;
+        return !(fields >> extra);  // Nothing may follow
+    }
+    static_assert(sizeof(SceneHeader) == headerBytes, "scene header must be 64 bytes");
+
+    bool endsWith(const std::string& text, const char* suffix) {
+        size_t length = std::strlen(suffix);
+        return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+    }
+}
+
+bool SceneIO::load(const std::string& path, ElectricField& field) {
+    char magic[sizeof(sceneMagic)] = {};
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    in.read(magic, sizeof(magic));
+    bool binary = in.gcount() == sizeof(magic) && std::memcmp(magic, sceneMagic, sizeof(magic)) == 0;
+    in.close();
+
+    return binary ? loadBinary(path, field) : loadText(path, field);
+}
+
+bool SceneIO::save(const std::string& path, const ElectricField& field) {
+    return endsWith(path, ".efs") ? saveBinary(path, field) : saveText(path, field);
+}
+
+bool SceneIO::loadBinary(const std::string& path, ElectricField& field) {
+    MappedFile file;
+    if (!file.openRead(path)) return false;
+
+    SceneHeader header;
+    if (file.getSize() < headerBytes) {
+        std::cerr << path << " is not a scene (too short)" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.getData(), sizeof(header));
+    if (std::memcmp(header.magic, sceneMagic, sizeof(sceneMagic)) != 0) {
+        std::cerr << path << " is not a binary scene" << std::endl;
+        return false;
+    }
+    if (header.version < 1 || header.version > sceneVersion || header.byteOrder != byteOrderMark) {
+        std::cerr << path << ": unsupported version or byte order" << std::endl;
+        return false;
+    }
+    if (header.version < 2) {
+        header.lineCount = header.arcCount = header.diskCount = 0;
+        header.polygonCount = header.polygonVertexCount = 0;
+    }
+    bool hasMass = (header.flags & hasMassFlag) != 0;
+    size_t arrays = hasMass ? 4 : 3;
+    if ((file.getSize() - headerBytes) / (arrays * sizeof(float)) < header.count) {
+        std::cerr << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    // The arrays follow the header 4-byte aligned, so the mapping is read in place
+    size_t count = static_cast<size_t>(header.count);
+    const float* xs = reinterpret_cast<const float*>(file.getData() + headerBytes);
+
+    // Then the sources, all 4-byte values too
+    size_t sourceWords = lineFloats * header.lineCount + arcFloats * header.arcCount + diskFloats * header.diskCount
+                       + 2 * static_cast<size_t>(header.polygonCount) + 2 * static_cast<size_t>(header.polygonVertexCount);
+    size_t sourceOffset = headerBytes + arrays * count * sizeof(float);
+    if ((file.getSize() - sourceOffset) / sizeof(float) < sourceWords) {
+        std::cerr << path << " is truncated" << std::endl;
+        return false;
+    }
+    const float* words = reinterpret_cast<const float*>(file.getData() + sourceOffset);
+    ContinuousSources sources;
+    for (uint32_t i = 0; i < header.lineCount; i++, words += lineFloats) {
+        sources.addLine(LineSource{glm::vec2(words[0], words[1]), glm::vec2(words[2], words[3]), words[4]});
+    }
+    for (uint32_t i = 0; i < header.arcCount; i++, words += arcFloats) {
+        sources.addArc(ArcSource{glm::vec2(words[0], words[1]), words[2], words[3], words[4], words[5]});
+    }
+    for (uint32_t i = 0; i < header.diskCount; i++, words += diskFloats) {
+        sources.addDisk(DiskSource{glm::vec2(words[0], words[1]), words[2], words[3]});
+    }
+    const uint32_t* vertexCounts = reinterpret_cast<const uint32_t*>(words);
+    const float* polygonCharges = words + header.polygonCount;
+    const float* vertices = polygonCharges + header.polygonCount;
+    size_t verticesLeft = header.polygonVertexCount;
+    for (uint32_t i = 0; i < header.polygonCount; i++) {
+        if (vertexCounts[i] < 3 || vertexCounts[i] > verticesLeft) {
+            std::cerr << path << ": bad polygon vertex counts" << std::endl;
+            return false;
+        }
+        PolygonSource polygon;
+        polygon.charge = polygonCharges[i];
+        for (uint32_t v = 0; v < vertexCounts[i]; v++, vertices += 2) {
+            polygon.vertices.emplace_back(vertices[0], vertices[1]);
+        }
+        verticesLeft -= vertexCounts[i];
+        sources.addPolygon(polygon);
+    }
+
+    field.setCharges(xs, xs + count, xs + 2 * count, count, hasMass ? xs + 3 * count : nullptr);
+    replaceSources(field, sources);
+    return true;
+}
+
+bool SceneIO::loadText(const std::string& path, ElectricField& field) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    // Parsed in full first, so a bad line leaves the field untouched
+    std::vector<float> xs, ys, qs, masses;
+    ContinuousSources sources;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) continue;   // Blank line
+        if (std::isalpha(static_cast<unsigned char>(first[0]))) {
+            if (!parseSource(first, fields, sources)) {
+                std::cerr << path << ":" << lineNumber << ": bad " << first << " source" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        fields.clear();
+        fields.str(line);
+        float x, y, q, mass = 1.0f;
+        if (!(fields >> x >> y >> q)) {
+            std::cerr << path << ":" << lineNumber << ": expected \"x y q [mass]\"" << std::endl;
+            return false;
+        }
+        // An optional mass, then nothing else
+        std::string extra;
+        if (fields >> extra) {
+            std::istringstream massField(extra);
+            if (!(massField >> mass) || !massField.eof() || (fields >> extra)) {
+                std::cerr << path << ":" << lineNumber << ": expected \"x y q [mass]\"" << std::endl;
+                return false;
+            }
+        }
+        xs.push_back(x);
+        ys.push_back(y);
+        qs.push_back(q);
+        masses.push_back(mass);
+    }
+
+    field.setCharges(xs.data(), ys.data(), qs.data(), xs.size(), masses.data());
+    replaceSources(field, sources);
+    return true;
+}
+
+bool SceneIO::saveBinary(const std::string& path, const ElectricField& field) {
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    const ChargeStorage& storage = field.getChargeStorage();
+    SceneHeader header = {};
+    std::memcpy(header.magic, sceneMagic, sizeof(sceneMagic));
+    header.version = sceneVersion;
+    header.byteOrder = byteOrderMark;
+    header.count = storage.size();
+    header.flags = hasMassFlag;
+
+    size_t count = storage.size();
+    std::vector<float> masses(count);
+    for (size_t i = 0; i < count; i++) masses[i] = field.getCharges()[i].mass;
+
+    // The sources as 4-byte words, in the order the header counts them
+    const ContinuousSources& sources = field.getSources();
+    header.lineCount = static_cast<uint32_t>(sources.getLines().size());
+    header.arcCount = static_cast<uint32_t>(sources.getArcs().size());
+    header.diskCount = static_cast<uint32_t>(sources.getDisks().size());
+    header.polygonCount = static_cast<uint32_t>(sources.getPolygons().size());
+    std::vector<float> sourceWords;
+    for (const LineSource& line : sources.getLines()) {
+        sourceWords.insert(sourceWords.end(), {line.start.x, line.start.y, line.end.x, line.end.y, line.charge});
+    }
+    for (const ArcSource& arc : sources.getArcs()) {
+        sourceWords.insert(sourceWords.end(), {arc.center.x, arc.center.y, arc.radius, arc.startAngle, arc.endAngle, arc.charge});
+    }
+    for (const DiskSource& disk : sources.getDisks()) {
+        sourceWords.insert(sourceWords.end(), {disk.center.x, disk.center.y, disk.radius, disk.charge});
+    }
+    for (const PolygonSource& polygon : sources.getPolygons()) {
+        uint32_t vertexCount = static_cast<uint32_t>(polygon.vertices.size());
+        float word;
+        std::memcpy(&word, &vertexCount, sizeof(word));
+        sourceWords.push_back(word);
+        header.polygonVertexCount += vertexCount;
+    }
+    for (const PolygonSource& polygon : sources.getPolygons()) sourceWords.push_back(polygon.charge);
+    for (const PolygonSource& polygon : sources.getPolygons()) {
+        for (const glm::vec2& vertex : polygon.vertices) sourceWords.insert(sourceWords.end(), {vertex.x, vertex.y});
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1
+           && std::fwrite(storage.x.data(), sizeof(float), count, out) == count
+           && std::fwrite(storage.y.data(), sizeof(float), count, out) == count
+           && std::fwrite(storage.q.data(), sizeof(float), count, out) == count
+           && std::fwrite(masses.data(), sizeof(float), count, out) == count
+           && std::fwrite(sourceWords.data(), sizeof(float), sourceWords.size(), out) == sourceWords.size();
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) std::cerr << "Could not write " << path << std::endl;
+    return ok;
+}
+
+bool SceneIO::saveText(const std::string& path, const ElectricField& field) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    // %.9g round-trips a float exactly
+    const ChargeStorage& storage = field.getChargeStorage();
+    const std::vector<ElectricCharge>& charges = field.getCharges();
+    bool ok = std::fputs("# x y q mass\n", out) >= 0;
+    for (size_t i = 0; i < storage.size() && ok; i++) {
+        ok = std::fprintf(out, "%.9g %.9g %.9g %.9g\n", storage.x[i], storage.y[i], storage.q[i], charges[i].mass) >= 0;
+    }
+
+    const ContinuousSources& sources = field.getSources();
+    for (const LineSource& line : sources.getLines()) {
+        if (!ok) break;
+        ok = std::fprintf(out, "line %.9g %.9g %.9g %.9g %.9g\n",
+                          line.start.x, line.start.y, line.end.x, line.end.y, line.charge) >= 0;
+    }
+    for (const ArcSource& arc : sources.getArcs()) {
+        if (!ok) break;
+        ok = std::fprintf(out, "arc %.9g %.9g %.9g %.9g %.9g %.9g\n",
+                          arc.center.x, arc.center.y, arc.radius, arc.startAngle, arc.endAngle, arc.charge) >= 0;
+    }
+    for (const DiskSource& disk : sources.getDisks()) {
+        if (!ok) break;
+        ok = std::fprintf(out, "disk %.9g %.9g %.9g %.9g\n", disk.center.x, disk.center.y, disk.radius, disk.charge) >= 0;
+    }
+    for (const PolygonSource& polygon : sources.getPolygons()) {
+        if (!ok) break;
+        ok = std::fprintf(out, "polygon %.9g", polygon.charge) >= 0;
+        for (const glm::vec2& vertex : polygon.vertices) {
+            ok = ok && std::fprintf(out, " %.9g %.9g", vertex.x, vertex.y) >= 0;
+        }
+        ok = ok && std::fputc('\n', out) != EOF;
+    }
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) std::cerr << "Could not write " << path << std::endl;
+    return ok;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+
+class ElectricField;
+
+// Saving and loading scenes: the point charges and the continuous sources.
+// Loading replaces both.
+//
+// Binary scenes (.efs) are a 64-byte header followed by the x, y and q
+// arrays, each count float32 values in the machine's byte order, then a
+// mass array of the same length when the header's hasMass flag is set.
+// Version 2 files then hold the sources, counted in the header: lines
+// (x0 y0 x1 y1 q), arcs (cx cy r a0 a1 q) and disks (cx cy r q) as float32
+// records, then the polygons as a uint32 vertex count each, a float32
+// charge each and all their x y vertices back to back. Version 1 files
+// have no sources.
+// Loading maps the file and copies the arrays straight into the field's
+// structure-of-arrays storage, so a million charges load in milliseconds.
+// Text scenes hold one "x y q [mass]" per line; '#' starts a comment. A
+// missing mass is 1. Sources are lines starting with a keyword:
+//   line x0 y0 x1 y1 q
+//   arc cx cy r a0 a1 q
+//   disk cx cy r q
+//   polygon q x0 y0 x1 y1 x2 y2 ...
+// They are meant for small, hand-edited scenes.
+class SceneIO {
+public:
+    // Picks the format from the file contents
+    static bool load(const std::string& path, ElectricField& field);
+
+    // Binary for .efs paths, text otherwise
+    static bool save(const std::string& path, const ElectricField& field);
+
+    static bool loadBinary(const std::string& path, ElectricField& field);
+    static bool loadText(const std::string& path, ElectricField& field);
+    static bool saveBinary(const std::string& path, const ElectricField& field);
+    static bool saveText(const std::string& path, const ElectricField& field);
+};
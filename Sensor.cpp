@@ -2,13 +2,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
-#include <iomanip>
-#include <sstream>
 
 #include "Sensor.hpp"
+#include "Profiler.hpp"
+#include "FrameArena.hpp"
 
-Sensor::Sensor(TextRender* textRenderer, GLFWwindow* window)
-    : textRenderer(textRenderer), window(window), position(0.0f, 0.0f), fieldVector(0.0f, 0.0f), active(false) {
+Sensor::Sensor(TextRender* textRenderer, const Camera* camera)
+    : textRenderer(textRenderer), camera(camera), position(0.0f, 0.0f), fieldVector(0.0f, 0.0f), active(false),
+      precision(FieldPrecision::Double) {
     setupSensor();
 }
 
@@ -72,7 +73,15 @@ glm::vec2 Sensor::getPosition() const {
 }
 
 void Sensor::updateFieldVector(const ElectricField& field) {
-    fieldVector = field.getFieldAt(position.x, position.y);
+    fieldVector = field.getFieldAt(position.x, position.y, precision);
+}
+
+void Sensor::setPrecision(FieldPrecision newPrecision) {
+    precision = newPrecision;
+}
+
+FieldPrecision Sensor::getPrecision() const {
+    return precision;
 }
 
 bool Sensor::isPointOnSensor(float x, float y, float radius) const {
@@ -90,36 +99,9 @@ void Sensor::setActive(bool active) {
     this->active = active;
 }
 
-// Helper method to get the current window's aspect ratio
-float Sensor::getAspectRatio() const {
-    int windowWidth, windowHeight;
-    glfwGetWindowSize(window, &windowWidth, &windowHeight);
-    return (float)windowWidth / (float)windowHeight;
-}
-
-// Helper method to convert world coordinates to screen coordinates
-glm::vec2 Sensor::worldToScreenCoords(const glm::vec2& worldPos) const {
-    int windowWidth, windowHeight;
-    glfwGetWindowSize(window, &windowWidth, &windowHeight);
-    float aspectRatio = getAspectRatio();
-    
-    float screenX, screenY;
-    
-    if (aspectRatio >= 1.0f) {
-        // Wider window
-        screenX = (worldPos.x / aspectRatio + 1.0f) * 0.5f * windowWidth;
-        screenY = (worldPos.y + 1.0f) * 0.5f * windowHeight;
-    } else {
-        // Taller window
-        screenX = (worldPos.x + 1.0f) * 0.5f * windowWidth;
-        screenY = (worldPos.y * aspectRatio + 1.0f) * 0.5f * windowHeight;
-    }
-    
-    return glm::vec2(screenX, screenY);
-}
-
 void Sensor::render(GLuint shaderProgram) {
     if (!active) return;
+    PROFILE_ZONE("Sensor::render");
     
     // Save current program to restore later
     GLint originalProgram;
@@ -160,16 +142,9 @@ void Sensor::render(GLuint shaderProgram) {
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
     }
     
-    // Create projection matrix using aspect ratio - consistent with main.cpp
-    float aspectRatio = getAspectRatio();
+    // Projection of the camera, as for everything else in the world
     if (projLoc != -1) {
-        if (aspectRatio >= 1.0f) {
-            // Wider window
-            projection = glm::ortho(-1.0f * aspectRatio, 1.0f * aspectRatio, -1.0f, 1.0f);
-        } else {
-            // Taller window
-            projection = glm::ortho(-1.0f, 1.0f, -1.0f / aspectRatio, 1.0f / aspectRatio);
-        }
+        projection = camera->getProjection();
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
     }
     
@@ -266,8 +241,8 @@ void Sensor::render(GLuint shaderProgram) {
 }
 
 void Sensor::renderSensorData() {
-    // Now using our helper method to convert world coords to screen coords
-    glm::vec2 screenPos = worldToScreenCoords(position);
+    // Labels follow the sensor through the camera
+    glm::vec2 screenPos = camera->worldToScreen(position);
     float screenX = screenPos.x;
     float screenY = screenPos.y;
     
@@ -281,28 +256,29 @@ void Sensor::renderSensorData() {
     }
     
     // Prepare text to display
-    std::stringstream posText, magText, dirText;
+    FrameArena& arena = FrameArena::frame();
     
     // Format position with 2 decimals
-    posText << "Pos: (" << std::fixed << std::setprecision(2) << position.x << ", " 
-            << std::fixed << std::setprecision(2) << position.y << ")";
+    std::string_view posText = arena.format("Pos: (%.2f, %.2f)", position.x, position.y);
     
     // Format magnitude with appropriate scientific notation
+    std::string_view magText;
     if (magnitude < 0.001f) {
-        magText << "E: ~0 N/C";
+        magText = "E: ~0 N/C";
     } else if (magnitude < 0.01f) {
-        magText << "E: " << std::fixed << std::setprecision(5) << magnitude << " N/C";
+        magText = arena.format("E: %.5f N/C", magnitude);
     } else if (magnitude < 100.0f) {
-        magText << "E: " << std::fixed << std::setprecision(3) << magnitude << " N/C";
+        magText = arena.format("E: %.3f N/C", magnitude);
     } else {
-        magText << "E: " << std::scientific << std::setprecision(2) << magnitude << " N/C";
+        magText = arena.format("E: %.2e N/C", magnitude);
     }
     
     // Format direction with 1 decimal
+    std::string_view dirText;
     if (magnitude < 0.001f) {
-        dirText << "Dir: N/A";
+        dirText = "Dir: N/A";
     } else {
-        dirText << "Dir: " << std::fixed << std::setprecision(1) << direction << "°";
+        dirText = arena.format("Dir: %.1f°", direction);
     }
     
     // Render text information
@@ -310,7 +286,7 @@ void Sensor::renderSensorData() {
     float textScale = 0.5f;
     float textOffsetY = 15.0f;
     
-    textRenderer->renderText(posText.str(), screenX + 15.0f, screenY - textOffsetY, textScale, textColor);
-    textRenderer->renderText(magText.str(), screenX + 15.0f, screenY - 2*textOffsetY, textScale, textColor);
-    textRenderer->renderText(dirText.str(), screenX + 15.0f, screenY - 3*textOffsetY, textScale, textColor);
+    textRenderer->renderText(posText, screenX + 15.0f, screenY - textOffsetY, textScale, textColor);
+    textRenderer->renderText(magText, screenX + 15.0f, screenY - 2*textOffsetY, textScale, textColor);
+    textRenderer->renderText(dirText, screenX + 15.0f, screenY - 3*textOffsetY, textScale, textColor);
 }
\ No newline at end of file
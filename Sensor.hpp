@@ -6,10 +6,11 @@
 
 #include "ElectricField.hpp"
 #include "TextRender.hpp"
+#include "Camera.hpp"
 
 class Sensor {
 public:
-    Sensor(TextRender* textRenderer, GLFWwindow* window);
+    Sensor(TextRender* textRenderer, const Camera* camera);
     ~Sensor();
     
     // Initialize the sensor at a specific position
@@ -20,6 +21,11 @@ public:
     
     // Calculate and update the field vector at the sensor position
     void updateFieldVector(const ElectricField& field);
+
+    // Accumulation used for the reading (double by default: it is one
+    // point, and near dipoles the float sum cancels to noise)
+    void setPrecision(FieldPrecision newPrecision);
+    FieldPrecision getPrecision() const;
     
     // Render the sensor and field vector
     void render(GLuint shaderProgram);
@@ -35,7 +41,7 @@ public:
 
 private:
     TextRender* textRenderer;
-    GLFWwindow* window;
+    const Camera* camera;          // Projection and label placement
     
     glm::vec2 position;            // Position of the sensor
     glm::vec2 fieldVector;         // Direction and magnitude of the electric field
@@ -43,11 +49,8 @@ private:
     GLuint VAO, VBO;               // OpenGL objects for sensor rendering
     
     bool active;                   // Is the sensor active/visible?
+    FieldPrecision precision;      // Accumulation used for the reading
     
     void setupSensor();            // Initialize sensor geometry
     void renderSensorData();       // Render text information about field at sensor
-    
-    // Helper methods for coordinate transformations
-    float getAspectRatio() const;
-    glm::vec2 worldToScreenCoords(const glm::vec2& worldPos) const;
 };
\ No newline at end of file
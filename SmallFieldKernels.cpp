@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+#include "SmallFieldKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SMALL_FIELD_SSE 1
+#endif
+
+namespace {
+    // Policies: the 1/|r|^3 factor of one charge, scalar and 4-wide.
+    // Written without branches so the compiler never has to guard a sqrt.
+
+    struct HardCutoff {
+        static float inverseCube(float d2, float eps2) {
+            float invDist = 1.0f / std::sqrt(std::max(d2, eps2));
+            return d2 >= eps2 ? invDist * invDist * invDist : 0.0f;
+        }
+#if SMALL_FIELD_SSE
+        static __m128 inverseCube(__m128 d2, __m128 eps2) {
+            __m128 invDist = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(d2, eps2)));
+            return _mm_and_ps(_mm_mul_ps(_mm_mul_ps(invDist, invDist), invDist), _mm_cmpge_ps(d2, eps2));
+        }
+#endif
+    };
+
+    struct PlummerSoftening {
+        static float inverseCube(float d2, float eps2) {
+            float invDist = 1.0f / std::sqrt(d2 + eps2);
+            return invDist * invDist * invDist;
+        }
+#if SMALL_FIELD_SSE
+        static __m128 inverseCube(__m128 d2, __m128 eps2) {
+            __m128 invDist = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_add_ps(d2, eps2)));
+            return _mm_mul_ps(_mm_mul_ps(invDist, invDist), invDist);
+        }
+#endif
+    };
+
+    // A query exactly on a charge skips it rather than returning Inf/NaN
+    struct NoSoftening {
+        static float inverseCube(float d2, float) {
+            float invDist = 1.0f / std::sqrt(d2);
+            return d2 > 0.0f ? invDist * invDist * invDist : 0.0f;
+        }
+#if SMALL_FIELD_SSE
+        static __m128 inverseCube(__m128 d2, __m128) {
+            __m128 invDist = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(d2));
+            return _mm_and_ps(_mm_mul_ps(_mm_mul_ps(invDist, invDist), invDist), _mm_cmpgt_ps(d2, _mm_setzero_ps()));
+        }
+#endif
+    };
+
+    template <typename Policy>
+    inline void addTerm(float cx, float cy, float cq, float x, float y, float eps2, float& sumX, float& sumY) {
+        float rx = x - cx;
+        float ry = y - cy;
+        float scale = cq * Policy::inverseCube(rx*rx + ry*ry, eps2);
+        sumX += scale * rx;
+        sumY += scale * ry;
+    }
+
+    // Charges First, First + 1, ... one term each, expanded at compile time
+    // (possibly none, hence maybe_unused)
+    template <typename Policy, size_t First, size_t... I>
+    inline void addTerms(std::index_sequence<I...>, const float* cx, const float* cy, const float* cq,
+                         [[maybe_unused]] float x, [[maybe_unused]] float y, [[maybe_unused]] float eps2,
+                         float& sumX, float& sumY) {
+        (addTerm<Policy>(cx[First + I], cy[First + I], cq[First + I], x, y, eps2, sumX, sumY), ...);
+    }
+
+    // One point: groups of 4 charges go through the SIMD lanes and the
+    // remaining 1-3 (or all of them without SSE) through unrolled scalar
+    // terms, which is faster than padding a partial group
+    template <size_t N, typename Policy>
+    void smallFieldAt(const float* cx, const float* cy, const float* cq,
+                      float x, float y, float eps2, float* ex, float* ey) {
+        float sumX = 0.0f;
+        float sumY = 0.0f;
+
+#if SMALL_FIELD_SSE
+        constexpr size_t grouped = N / 4 * 4;
+        if (grouped > 0) {
+            __m128 px = _mm_set1_ps(x);
+            __m128 py = _mm_set1_ps(y);
+            __m128 cutoff = _mm_set1_ps(eps2);
+            __m128 laneX = _mm_setzero_ps();
+            __m128 laneY = _mm_setzero_ps();
+            for (size_t g = 0; g < grouped; g += 4) {
+                __m128 rx = _mm_sub_ps(px, _mm_loadu_ps(cx + g));
+                __m128 ry = _mm_sub_ps(py, _mm_loadu_ps(cy + g));
+                __m128 d2 = _mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry));
+                __m128 scale = _mm_mul_ps(_mm_loadu_ps(cq + g), Policy::inverseCube(d2, cutoff));
+                laneX = _mm_add_ps(laneX, _mm_mul_ps(scale, rx));
+                laneY = _mm_add_ps(laneY, _mm_mul_ps(scale, ry));
+            }
+            alignas(16) float lx[4], ly[4];
+            _mm_store_ps(lx, laneX);
+            _mm_store_ps(ly, laneY);
+            sumX = (lx[0] + lx[1]) + (lx[2] + lx[3]);
+            sumY = (ly[0] + ly[1]) + (ly[2] + ly[3]);
+        }
+#else
+        constexpr size_t grouped = 0;
+#endif
+
+        addTerms<Policy, grouped>(std::make_index_sequence<N - grouped>(), cx, cy, cq, x, y, eps2, sumX, sumY);
+        *ex = sumX;
+        *ey = sumY;
+    }
+
+    // Many points: each charge is broadcast once, outside the target loop,
+    // and 4 targets go through the lanes per iteration
+    template <size_t N, typename Policy>
+    void smallFieldBatch(const float* cx, const float* cy, const float* cq,
+                         const float* xs, const float* ys, size_t n,
+                         float* ex, float* ey, float eps2) {
+        size_t t = 0;
+
+#if SMALL_FIELD_SSE
+        __m128 bx[N], by[N], bq[N];
+        for (size_t i = 0; i < N; i++) {
+            bx[i] = _mm_set1_ps(cx[i]);
+            by[i] = _mm_set1_ps(cy[i]);
+            bq[i] = _mm_set1_ps(cq[i]);
+        }
+        __m128 cutoff = _mm_set1_ps(eps2);
+
+        for (; t + 4 <= n; t += 4) {
+            __m128 px = _mm_loadu_ps(xs + t);
+            __m128 py = _mm_loadu_ps(ys + t);
+            __m128 sumX = _mm_setzero_ps();
+            __m128 sumY = _mm_setzero_ps();
+            for (size_t i = 0; i < N; i++) {
+                __m128 rx = _mm_sub_ps(px, bx[i]);
+                __m128 ry = _mm_sub_ps(py, by[i]);
+                __m128 d2 = _mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry));
+                __m128 scale = _mm_mul_ps(bq[i], Policy::inverseCube(d2, cutoff));
+                sumX = _mm_add_ps(sumX, _mm_mul_ps(scale, rx));
+                sumY = _mm_add_ps(sumY, _mm_mul_ps(scale, ry));
+            }
+            _mm_storeu_ps(ex + t, sumX);
+            _mm_storeu_ps(ey + t, sumY);
+        }
+#endif
+
+        for (; t < n; t++) {
+            float sumX = 0.0f;
+            float sumY = 0.0f;
+            addTerms<Policy, 0>(std::make_index_sequence<N>(), cx, cy, cq, xs[t], ys[t], eps2, sumX, sumY);
+            ex[t] = sumX;
+            ey[t] = sumY;
+        }
+    }
+
+    template <typename Policy>
+    void fieldBatchWithPolicy(const float* cx, const float* cy, const float* cq, size_t count,
+                              const float* xs, const float* ys, size_t n,
+                              float* ex, float* ey, float eps2) {
+        for (size_t t = 0; t < n; t++) {
+            float sumX = 0.0f;
+            float sumY = 0.0f;
+            for (size_t i = 0; i < count; i++) {
+                addTerm<Policy>(cx[i], cy[i], cq[i], xs[t], ys[t], eps2, sumX, sumY);
+            }
+            ex[t] = sumX;
+            ey[t] = sumY;
+        }
+    }
+
+    // Tables indexed [mode][count - 1]
+    template <typename Policy, size_t... I>
+    constexpr std::array<SmallFieldPointKernel, sizeof...(I)> makePointKernels(std::index_sequence<I...>) {
+        return {{ &smallFieldAt<I + 1, Policy>... }};
+    }
+
+    template <typename Policy, size_t... I>
+    constexpr std::array<SmallFieldBatchKernel, sizeof...(I)> makeBatchKernels(std::index_sequence<I...>) {
+        return {{ &smallFieldBatch<I + 1, Policy>... }};
+    }
+
+    using Counts = std::make_index_sequence<maxSmallFieldCharges>;
+
+    const std::array<SmallFieldPointKernel, maxSmallFieldCharges> pointKernels[3] = {
+        makePointKernels<HardCutoff>(Counts()),
+        makePointKernels<PlummerSoftening>(Counts()),
+        makePointKernels<NoSoftening>(Counts()),
+    };
+
+    const std::array<SmallFieldBatchKernel, maxSmallFieldCharges> batchKernels[3] = {
+        makeBatchKernels<HardCutoff>(Counts()),
+        makeBatchKernels<PlummerSoftening>(Counts()),
+        makeBatchKernels<NoSoftening>(Counts()),
+    };
+}
+
+SmallFieldPointKernel selectSmallFieldPointKernel(size_t count, SofteningMode mode) {
+    if (count == 0 || count > maxSmallFieldCharges) return nullptr;
+    return pointKernels[static_cast<int>(mode)][count - 1];
+}
+
+SmallFieldBatchKernel selectSmallFieldBatchKernel(size_t count, SofteningMode mode) {
+    if (count == 0 || count > maxSmallFieldCharges) return nullptr;
+    return batchKernels[static_cast<int>(mode)][count - 1];
+}
+
+void computeFieldBatchWithMode(SofteningMode mode, const float* cx, const float* cy, const float* cq, size_t count,
+                               const float* xs, const float* ys, size_t n,
+                               float* ex, float* ey, float eps2) {
+    switch (mode) {
+        case SofteningMode::HardCutoff:
+            fieldBatchWithPolicy<HardCutoff>(cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+            break;
+        case SofteningMode::Plummer:
+            fieldBatchWithPolicy<PlummerSoftening>(cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+            break;
+        case SofteningMode::None:
+            fieldBatchWithPolicy<NoSoftening>(cx, cy, cq, count, xs, ys, n, ex, ey, eps2);
+            break;
+    }
+}
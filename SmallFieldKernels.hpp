@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+// Field kernels specialised at compile time for scenes with a handful of
+// charges (most classroom scenes have 1 to 8). The charge count is a
+// template parameter, so the loop over charges is fully unrolled, and the
+// treatment of close charges is a policy type instead of a branch. The
+// kernel for the current scene size is picked at runtime from a table.
+
+// How the direct sum treats a target close to a charge
+enum class SofteningMode {
+    HardCutoff,   // Skip charges closer than the cutoff (the classic behaviour)
+    Plummer,      // 1 / (|r|^2 + eps^2)^(3/2): smooth and bounded
+    None          // Plain 1 / |r|^3, unbounded near the charges (a charge is
+                  // skipped only by a query exactly on it)
+};
+
+// Largest charge count with a specialised kernel
+constexpr size_t maxSmallFieldCharges = 8;
+
+// Field of the charges at one point (x, y)
+using SmallFieldPointKernel = void (*)(const float* cx, const float* cy, const float* cq,
+                                       float x, float y, float eps2, float* ex, float* ey);
+
+// Field of the charges at n points
+using SmallFieldBatchKernel = void (*)(const float* cx, const float* cy, const float* cq,
+                                       const float* xs, const float* ys, size_t n,
+                                       float* ex, float* ey, float eps2);
+
+// Kernels for exactly count charges under the given mode, or nullptr when
+// count is 0 or above maxSmallFieldCharges
+SmallFieldPointKernel selectSmallFieldPointKernel(size_t count, SofteningMode mode);
+SmallFieldBatchKernel selectSmallFieldBatchKernel(size_t count, SofteningMode mode);
+
+// Any charge count, any mode (plain loop, for the modes the SIMD kernels in
+// FieldKernels.hpp do not cover)
+void computeFieldBatchWithMode(SofteningMode mode, const float* cx, const float* cy, const float* cq, size_t count,
+                               const float* xs, const float* ys, size_t n,
+                               float* ex, float* ey, float eps2);
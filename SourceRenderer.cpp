@@ -0,0 +1,182 @@
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include "SourceRenderer.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    const float pi = 3.14159265f;
+    const int circleSegments = 64;     // Per full turn, fewer for shorter arcs
+
+    void pushVertex(std::vector<float>& out, glm::vec2 p) {
+        out.push_back(p.x);
+        out.push_back(p.y);
+    }
+
+    void pushArcOutline(std::vector<float>& out, glm::vec2 center, float radius, float startAngle, float span) {
+        int segments = std::max(4, static_cast<int>(std::ceil(circleSegments * span / (2.0f * pi))));
+        for (int i = 0; i < segments; i++) {
+            float a0 = startAngle + span * i / segments;
+            float a1 = startAngle + span * (i + 1) / segments;
+            pushVertex(out, center + radius * glm::vec2(std::cos(a0), std::sin(a0)));
+            pushVertex(out, center + radius * glm::vec2(std::cos(a1), std::sin(a1)));
+        }
+    }
+
+    float cross(glm::vec2 a, glm::vec2 b, glm::vec2 c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    // Ear clipping, O(n^2): plenty for hand-drawn plates
+    void pushPolygonFill(std::vector<float>& out, const std::vector<glm::vec2>& vertices) {
+        std::vector<int> remaining(vertices.size());
+        float area = 0.0f;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            remaining[i] = static_cast<int>(i);
+            const glm::vec2& p = vertices[i];
+            const glm::vec2& q = vertices[(i + 1) % vertices.size()];
+            area += p.x * q.y - q.x * p.y;
+        }
+        float winding = area > 0.0f ? 1.0f : -1.0f;
+
+        while (remaining.size() > 3) {
+            size_t n = remaining.size();
+            bool clipped = false;
+            for (size_t i = 0; i < n && !clipped; i++) {
+                glm::vec2 a = vertices[remaining[(i + n - 1) % n]];
+                glm::vec2 b = vertices[remaining[i]];
+                glm::vec2 c = vertices[remaining[(i + 1) % n]];
+                if (winding * cross(a, b, c) <= 0.0f) continue;   // Reflex corner
+
+                bool empty = true;
+                for (size_t j = 0; j < n && empty; j++) {
+                    if (j == i || j == (i + 1) % n || j == (i + n - 1) % n) continue;
+                    glm::vec2 p = vertices[remaining[j]];
+                    empty = !(winding * cross(a, b, p) >= 0.0f && winding * cross(b, c, p) >= 0.0f
+                              && winding * cross(c, a, p) >= 0.0f);
+                }
+                if (!empty) continue;
+
+                pushVertex(out, a);
+                pushVertex(out, b);
+                pushVertex(out, c);
+                remaining.erase(remaining.begin() + i);
+                clipped = true;
+            }
+            if (!clipped) return;   // Self-intersecting: leave the rest unfilled
+        }
+        if (remaining.size() == 3) {
+            for (int index : remaining) pushVertex(out, vertices[index]);
+        }
+    }
+}
+
+SourceRenderer::SourceRenderer() : capacity(0), uploadedVersion(0), uploaded(false),
+                                   fillFirst{0, 0}, lineFirst{0, 0}, fillCount{0, 0}, lineCount{0, 0} {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+SourceRenderer::~SourceRenderer() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+}
+
+void SourceRenderer::rebuild(const ContinuousSources& sources) {
+    std::vector<float> vertices;
+
+    for (int sign = 0; sign < 2; sign++) {
+        auto matches = [sign](float charge) { return (charge < 0.0f) == (sign == 1); };
+
+        fillFirst[sign] = static_cast<GLint>(vertices.size() / 2);
+        for (const DiskSource& disk : sources.getDisks()) {
+            if (!matches(disk.charge)) continue;
+            for (int i = 0; i < circleSegments; i++) {
+                float a0 = 2.0f * pi * i / circleSegments;
+                float a1 = 2.0f * pi * (i + 1) / circleSegments;
+                pushVertex(vertices, disk.center);
+                pushVertex(vertices, disk.center + disk.radius * glm::vec2(std::cos(a0), std::sin(a0)));
+                pushVertex(vertices, disk.center + disk.radius * glm::vec2(std::cos(a1), std::sin(a1)));
+            }
+        }
+        for (const PolygonSource& polygon : sources.getPolygons()) {
+            if (matches(polygon.charge) && polygon.vertices.size() >= 3) pushPolygonFill(vertices, polygon.vertices);
+        }
+        fillCount[sign] = static_cast<GLsizei>(vertices.size() / 2) - fillFirst[sign];
+
+        lineFirst[sign] = static_cast<GLint>(vertices.size() / 2);
+        for (const LineSource& line : sources.getLines()) {
+            if (!matches(line.charge)) continue;
+            pushVertex(vertices, line.start);
+            pushVertex(vertices, line.end);
+        }
+        for (const ArcSource& arc : sources.getArcs()) {
+            if (!matches(arc.charge)) continue;
+            float span = std::min(arc.endAngle - arc.startAngle, 2.0f * pi);
+            if (span > 0.0f) pushArcOutline(vertices, arc.center, arc.radius, arc.startAngle, span);
+        }
+        for (const DiskSource& disk : sources.getDisks()) {
+            if (matches(disk.charge)) pushArcOutline(vertices, disk.center, disk.radius, 0.0f, 2.0f * pi);
+        }
+        for (const PolygonSource& polygon : sources.getPolygons()) {
+            if (!matches(polygon.charge)) continue;
+            for (size_t i = 0; i < polygon.vertices.size(); i++) {
+                pushVertex(vertices, polygon.vertices[i]);
+                pushVertex(vertices, polygon.vertices[(i + 1) % polygon.vertices.size()]);
+            }
+        }
+        lineCount[sign] = static_cast<GLsizei>(vertices.size() / 2) - lineFirst[sign];
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (vertices.size() > capacity) {
+        capacity = vertices.size();
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(float), nullptr, GL_STATIC_DRAW);
+    }
+    if (!vertices.empty()) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    uploadedVersion = sources.getVersion();
+    uploaded = true;
+}
+
+void SourceRenderer::draw(const ContinuousSources& sources, GLuint shaderProgram, const glm::mat4& projection) {
+    PROFILE_ZONE("SourceRenderer::draw");
+    if (sources.empty()) return;
+    if (!uploaded || sources.getVersion() != uploadedVersion) rebuild(sources);
+
+    // Same colours as the charges: dim fills under bright outlines
+    const glm::vec3 fillColors[2] = {glm::vec3(0.45f, 0.12f, 0.12f), glm::vec3(0.12f, 0.18f, 0.45f)};
+    const glm::vec3 lineColors[2] = {glm::vec3(1.0f, 0.2f, 0.2f), glm::vec3(0.2f, 0.4f, 1.0f)};
+
+    glm::mat4 identity = glm::mat4(1.0f);
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    GLint colorLocation = glGetUniformLocation(shaderProgram, "color");
+
+    glBindVertexArray(VAO);
+    for (int sign = 0; sign < 2; sign++) {
+        if (fillCount[sign] == 0) continue;
+        glUniform3fv(colorLocation, 1, glm::value_ptr(fillColors[sign]));
+        glDrawArrays(GL_TRIANGLES, fillFirst[sign], fillCount[sign]);
+    }
+    for (int sign = 0; sign < 2; sign++) {
+        if (lineCount[sign] == 0) continue;
+        glUniform3fv(colorLocation, 1, glm::value_ptr(lineColors[sign]));
+        glDrawArrays(GL_LINES, lineFirst[sign], lineCount[sign]);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "ContinuousSources.hpp"
+
+// Draws the continuous sources of a field: disks and polygons filled,
+// every source outlined, red for positive charge and blue for negative.
+// The geometry is rebuilt only when the sources' version changes, so a
+// static scene costs four draw calls per frame from one VBO.
+class SourceRenderer {
+public:
+    SourceRenderer();
+    ~SourceRenderer();
+
+    // Draws with a shader that has model/view/projection and color uniforms
+    // (the sensor shader)
+    void draw(const ContinuousSources& sources, GLuint shaderProgram, const glm::mat4& projection);
+
+private:
+    GLuint VAO, VBO;
+    size_t capacity;              // Buffer size in floats
+    uint64_t uploadedVersion;
+    bool uploaded;
+
+    // Vertex ranges in the buffer: fills (triangles) and outlines (lines),
+    // each positive then negative
+    GLint fillFirst[2], lineFirst[2];
+    GLsizei fillCount[2], lineCount[2];
+
+    void rebuild(const ContinuousSources& sources);
+};
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "SpatialHash.hpp"
+
+namespace {
+    // Never a real cell, since cells are clamped to +-INT_MAX/2: marks empty
+    // table slots and points that are not indexed
+    const uint64_t noKey = 0x8000000080000000ull;
+    const size_t minTableSize = 64;
+
+    // Non-finite points (a blown-up simulation, a bad scene file) are not
+    // indexed: they have no cell and no query can be near them
+    bool isFinite(float x, float y) {
+        return std::isfinite(x) && std::isfinite(y);
+    }
+
+    // Neighbouring cells have neighbouring keys, so mix the bits first
+    size_t hashKey(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+}
+
+SpatialHash::SpatialHash(float cellSize) : cellSize(cellSize), inverseCellSize(1.0f / cellSize) {}
+
+int SpatialHash::cellOf(float v) const {
+    // Clamped so far-away points share the outermost cells instead of
+    // overflowing int, and cell ranges can be walked without wrapping
+    const double limit = INT_MAX / 2;
+    double cell = std::floor(static_cast<double>(v) * inverseCellSize);
+    if (!(cell > -limit)) cell = -limit;    // Also catches NaN
+    if (cell > limit) cell = limit;
+    return static_cast<int>(cell);
+}
+
+uint64_t SpatialHash::key(int cx, int cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+uint64_t SpatialHash::keyOf(float x, float y) const {
+    return isFinite(x, y) ? key(cellOf(x), cellOf(y)) : noKey;
+}
+
+size_t SpatialHash::findSlot(uint64_t cellKey) const {
+    // The table is at most half full, so probing always meets an empty slot
+    size_t mask = table.size() - 1;
+    size_t slot = hashKey(cellKey) & mask;
+    while (table[slot].key != cellKey && table[slot].key != noKey) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void SpatialHash::rehash() {
+    size_t live = 0;
+    for (const Cell& cell : table) live += cell.head >= 0;
+
+    // Room for as many new cells again before the next rehash; the table
+    // never shrinks, so a steady point count stops allocating
+    size_t size = std::max(table.size(), minTableSize);
+    while ((live + 1) * 4 > size) size *= 2;
+
+    spareTable.assign(size, Cell{noKey, -1});
+    size_t mask = size - 1;
+    for (const Cell& cell : table) {
+        if (cell.head < 0) continue;
+        size_t slot = hashKey(cell.key) & mask;
+        while (spareTable[slot].key != noKey) slot = (slot + 1) & mask;
+        spareTable[slot] = cell;
+    }
+    table.swap(spareTable);
+    usedSlots = live;
+}
+
+void SpatialHash::link(int index, uint64_t cellKey) {
+    size_t slot = table.empty() ? 0 : findSlot(cellKey);
+    if (table.empty() || table[slot].key == noKey) {
+        if ((usedSlots + 1) * 2 > table.size()) {
+            rehash();
+            slot = findSlot(cellKey);
+        }
+        table[slot] = Cell{cellKey, -1};
+        usedSlots++;
+    }
+
+    int head = table[slot].head;
+    next[index] = head;
+    previous[index] = -1;
+    if (head >= 0) previous[head] = index;
+    table[slot].head = index;
+    pointKeys[index] = cellKey;
+}
+
+void SpatialHash::unlink(int index) {
+    // Emptied cells keep their slot until the next rehash, so a point moving
+    // back and forth across a cell border finds its old slot again
+    if (next[index] >= 0) previous[next[index]] = previous[index];
+    if (previous[index] >= 0) {
+        next[previous[index]] = next[index];
+    } else {
+        table[findSlot(pointKeys[index])].head = next[index];
+    }
+    pointKeys[index] = noKey;
+}
+
+void SpatialHash::insert(int index, float x, float y) {
+    move(index, x, y);
+}
+
+void SpatialHash::move(int index, float newX, float newY) {
+    if (index < 0) return;
+    size_t needed = static_cast<size_t>(index) + 1;
+    if (pointKeys.size() < needed) {
+        next.resize(needed, -1);
+        previous.resize(needed, -1);
+        pointKeys.resize(needed, noKey);
+    }
+
+    uint64_t to = keyOf(newX, newY);
+    if (to == pointKeys[index]) return;
+    if (pointKeys[index] != noKey) unlink(index);
+    if (to != noKey) link(index, to);
+}
+
+void SpatialHash::clear() {
+    std::fill(table.begin(), table.end(), Cell{noKey, -1});
+    usedSlots = 0;
+    next.clear();
+    previous.clear();
+    pointKeys.clear();
+}
+
+void SpatialHash::rebuild(const float* xs, const float* ys, size_t count) {
+    // Sized for every point in a cell of its own up front, and refilled in
+    // place, so rebuilding every dynamics step does not allocate however the
+    // points spread out
+    size_t size = std::max(table.size(), minTableSize);
+    while ((count + 1) * 4 > size) size *= 2;
+    table.assign(size, Cell{noKey, -1});
+    usedSlots = 0;
+    next.resize(count);
+    previous.resize(count);
+    pointKeys.assign(count, noKey);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t cellKey = keyOf(xs[i], ys[i]);
+        if (cellKey != noKey) link(static_cast<int>(i), cellKey);
+    }
+}
+
+template <typename Visit>
+void SpatialHash::forEachNear(float x, float y, float radius, Visit visit) const {
+    if (!isFinite(x, y) || std::isnan(radius) || usedSlots == 0) return;
+    int minX = cellOf(x - radius), maxX = cellOf(x + radius);
+    int minY = cellOf(y - radius), maxY = cellOf(y + radius);
+
+    // Wide queries: walking the table is cheaper than the range
+    double rangeCells = (static_cast<double>(maxX) - minX + 1) * (static_cast<double>(maxY) - minY + 1);
+    if (rangeCells > static_cast<double>(usedSlots)) {
+        for (const Cell& cell : table) {
+            for (int index = cell.head; index >= 0; index = next[index]) {
+                if (!visit(index)) return;
+            }
+        }
+        return;
+    }
+
+    // Missing cells land on an empty slot, whose list is empty
+    for (int cx = minX; cx <= maxX; cx++) {
+        for (int cy = minY; cy <= maxY; cy++) {
+            const Cell& cell = table[findSlot(key(cx, cy))];
+            for (int index = cell.head; index >= 0; index = next[index]) {
+                if (!visit(index)) return;
+            }
+        }
+    }
+}
+
+int SpatialHash::findLowestWithin(float x, float y, float radius, const float* xs, const float* ys,
+                                  int exclude) const {
+    int lowest = -1;
+    forEachNear(x, y, radius, [&](int i) {
+        if (i == exclude) return true;
+        float dx = xs[i] - x;
+        float dy = ys[i] - y;
+        if (dx*dx + dy*dy < radius*radius && (lowest < 0 || i < lowest)) lowest = i;
+        return true;
+    });
+    return lowest;
+}
+
+bool SpatialHash::anyWithin(float x, float y, float radius, const float* xs, const float* ys) const {
+    bool found = false;
+    forEachNear(x, y, radius, [&](int i) {
+        float dx = xs[i] - x;
+        float dy = ys[i] - y;
+        found = dx*dx + dy*dy < radius*radius;
+        return !found;
+    });
+    return found;
+}
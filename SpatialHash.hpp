@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform grid of square cells over the plane, hashed so it needs no bounds.
+// Each cell lists the indices of the points inside it, so "which points are
+// near (x, y)" only looks at the few cells the query circle overlaps
+// instead of at every point. Positions are not stored here: queries take
+// the caller's coordinate arrays. Points with a NaN or infinite coordinate
+// are left out, and cells are clamped to a finite range so points very far
+// away share the outermost cells.
+//
+// Storage is flat so points moving into new cells do not allocate: an
+// open-addressing table from cell to the first point in it, and per point
+// the next and previous point of the same cell. Once the table has grown
+// to the point count, rebuilds and moves reuse it, however far the points
+// drift.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize = 0.1f);
+
+    void insert(int index, float x, float y);
+    void move(int index, float newX, float newY);
+    void clear();
+
+    // Re-inserts points 0..count-1 from scratch (reusing the storage)
+    void rebuild(const float* xs, const float* ys, size_t count);
+
+    // Lowest index other than exclude closer than radius to (x, y), or -1
+    int findLowestWithin(float x, float y, float radius, const float* xs, const float* ys, int exclude = -1) const;
+
+    // Whether any point is closer than radius to (x, y)
+    bool anyWithin(float x, float y, float radius, const float* xs, const float* ys) const;
+
+private:
+    // A table slot: a cell and the first point in it (-1 once emptied; the
+    // slot keeps its key until the next rehash)
+    struct Cell {
+        uint64_t key;
+        int head;
+    };
+
+    float cellSize;
+    float inverseCellSize;
+    std::vector<Cell> table;        // Power-of-two size, linear probing
+    std::vector<Cell> spareTable;   // Rehash target, kept to reuse its memory
+    size_t usedSlots = 0;           // Slots holding a key, emptied cells included
+    std::vector<int> next, previous;
+    std::vector<uint64_t> pointKeys;  // Cell of each point, noKey when not indexed
+
+    int cellOf(float v) const;
+    static uint64_t key(int cx, int cy);
+    uint64_t keyOf(float x, float y) const;
+
+    // Slot holding key, or the empty slot where it would go
+    size_t findSlot(uint64_t cellKey) const;
+    void link(int index, uint64_t cellKey);
+    void unlink(int index);
+
+    // Drops the emptied cells, growing the table if the live ones need it
+    void rehash();
+
+    // Calls visit(index) for the points in the cells overlapping the circle
+    // until it returns false
+    template <typename Visit>
+    void forEachNear(float x, float y, float radius, Visit visit) const;
+};
@@ -0,0 +1,179 @@
+#include <algorithm>
+
+#include "TaskScheduler.hpp"
+
+namespace {
+    // Which pool (if any) the current thread works for, and its queue index
+    thread_local const TaskScheduler* workerOwner = nullptr;
+    thread_local int workerIndex = -1;
+}
+
+TaskScheduler::TaskScheduler(unsigned workerCount) : queuedJobs(0), stopping(false) {
+    if (workerCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    for (unsigned i = 0; i <= workerCount; i++) {
+        queues.push_back(std::make_unique<JobQueue>());
+    }
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping.store(true);
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+TaskScheduler& TaskScheduler::global() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+void TaskScheduler::JobQueue::pushBack(Job job) {
+    if (count == ring.size()) {
+        // Full: unwrap into a ring twice the size
+        std::vector<Job> grown(std::max<size_t>(ring.size() * 2, 64));
+        for (size_t i = 0; i < count; i++) grown[i] = std::move(ring[(first + i) % ring.size()]);
+        ring.swap(grown);
+        first = 0;
+    }
+    ring[(first + count) % ring.size()] = std::move(job);
+    count++;
+}
+
+TaskScheduler::Job TaskScheduler::JobQueue::popBack() {
+    count--;
+    return std::move(ring[(first + count) % ring.size()]);
+}
+
+TaskScheduler::Job TaskScheduler::JobQueue::popFront() {
+    Job job = std::move(ring[first]);
+    first = (first + 1) % ring.size();
+    count--;
+    return job;
+}
+
+int TaskScheduler::currentWorker() const {
+    return workerOwner == this ? workerIndex : -1;
+}
+
+void TaskScheduler::submit(TaskGroup& group, Task task) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    int self = currentWorker();
+    JobQueue& queue = *queues[self >= 0 ? self : static_cast<int>(workers.size())];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pushBack(Job{std::move(task), &group});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_one();
+}
+
+bool TaskScheduler::tryRunOne(int self) {
+    Job job;
+    bool found = false;
+
+    // Own queue first, newest job
+    if (self >= 0) {
+        JobQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.count > 0) {
+            job = own.popBack();
+            found = true;
+        }
+    }
+
+    // Then steal the oldest job of someone else, starting after ourselves
+    int count = static_cast<int>(queues.size());
+    for (int k = 1; !found && k <= count; k++) {
+        int victim = ((self >= 0 ? self : count - 1) + k) % count;
+        if (victim == self) continue;
+        JobQueue& other = *queues[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (other.count > 0) {
+            job = other.popFront();
+            found = true;
+        }
+    }
+
+    if (!found) return false;
+
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job.task();
+    job.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void TaskScheduler::wait(TaskGroup& group) {
+    int self = currentWorker();
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        if (!tryRunOne(self)) {
+            // Remaining tasks are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskScheduler::parallelForChunks(size_t begin, size_t end, size_t grain,
+                                      ChunkFunction function, const void* context) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+
+    // Not worth a task
+    if (end - begin <= grain) {
+        function(context, begin, end);
+        return;
+    }
+
+    // One task per thread that claims chunks until none are left; the
+    // counter balances the load like one task per chunk would, and the
+    // task captures a single pointer so std::function stores it inline
+    struct Range {
+        ChunkFunction function;
+        const void* context;
+        std::atomic<size_t> next;
+        size_t end, grain;
+    } range{function, context, {begin}, end, grain};
+
+    size_t chunkCount = (end - begin + grain - 1) / grain;
+    size_t taskCount = std::min<size_t>(chunkCount, getThreadCount());
+
+    TaskGroup group;
+    for (size_t t = 0; t < taskCount; t++) {
+        submit(group, [&range]() {
+            while (true) {
+                size_t chunk = range.next.fetch_add(range.grain, std::memory_order_relaxed);
+                if (chunk >= range.end) return;
+                range.function(range.context, chunk, std::min(range.end, chunk + range.grain));
+            }
+        });
+    }
+    wait(group);
+}
+
+void TaskScheduler::workerLoop(unsigned index) {
+    workerOwner = this;
+    workerIndex = static_cast<int>(index);
+
+    while (true) {
+        if (tryRunOne(workerIndex)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() {
+            return stopping.load() || queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping.load() && queuedJobs.load() == 0) return;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished tasks submitted through it; wait() on it to join them
+class TaskGroup {
+public:
+    TaskGroup() : pending(0) {}
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+private:
+    friend class TaskScheduler;
+    std::atomic<int> pending;
+};
+
+// Small work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// (LIFO, cache friendly) while idle workers steal from the front of the
+// others (FIFO, oldest and usually largest tasks first). Tasks submitted
+// from outside the pool go to a shared queue that everyone steals from.
+// The thread that calls wait() runs tasks too, so a pool with zero workers
+// still works (everything runs on the caller).
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+
+    // workerCount = 0 uses one worker per hardware thread besides the caller
+    explicit TaskScheduler(unsigned workerCount = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Queues a task; it may start running before submit returns
+    void submit(TaskGroup& group, Task task);
+
+    // Runs queued tasks on the calling thread until the group is done
+    void wait(TaskGroup& group);
+
+    // Calls body(chunkBegin, chunkEnd) over [begin, end) in chunks of `grain`.
+    // The body is passed by pointer, never wrapped in a std::function, so a
+    // call does not touch the heap
+    template <typename Body>
+    void parallelFor(size_t begin, size_t end, size_t grain, const Body& body) {
+        parallelForChunks(begin, end, grain, [](const void* context, size_t chunkBegin, size_t chunkEnd) {
+            (*static_cast<const Body*>(context))(chunkBegin, chunkEnd);
+        }, &body);
+    }
+
+    // Worker threads plus the calling thread
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Pool shared by the render loop, the sensor and analysis passes
+    static TaskScheduler& global();
+
+private:
+    struct Job {
+        Task task;
+        TaskGroup* group;
+    };
+
+    // Ring buffer of jobs; it only grows, so a steady load of tasks stops
+    // allocating once it has seen its largest backlog
+    struct JobQueue {
+        std::mutex mutex;
+        std::vector<Job> ring;
+        size_t first = 0;
+        size_t count = 0;
+
+        void pushBack(Job job);
+        Job popBack();
+        Job popFront();
+    };
+
+    // One queue per worker, plus the shared queue at index workers.size()
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queuedJobs;
+    std::atomic<bool> stopping;
+
+    void workerLoop(unsigned index);
+
+    using ChunkFunction = void (*)(const void* context, size_t chunkBegin, size_t chunkEnd);
+    void parallelForChunks(size_t begin, size_t end, size_t grain, ChunkFunction function, const void* context);
+
+    // Pops a job from our own queue or steals one; returns false if none found
+    bool tryRunOne(int self);
+
+    // Queue index of the calling thread, or -1 if it is not one of our workers
+    int currentWorker() const;
+};
@@ -4,11 +4,28 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <codecvt>
-#include <locale>
+#include <algorithm>
 #include <GLFW/glfw3.h>
 
+#include "Profiler.hpp"
+
+namespace {
+    // Next codepoint of a UTF-8 string; malformed bytes decode to U+FFFD
+    char32_t decodeUtf8(const unsigned char*& p, const unsigned char* end) {
+        unsigned char lead = *p++;
+        if (lead < 0x80) return lead;
+
+        int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+        if (extra < 0 || lead >= 0xF8) return 0xFFFD;
+        char32_t codepoint = lead & (0x3F >> extra);
+        for (int i = 0; i < extra; i++) {
+            if (p == end || (*p & 0xC0) != 0x80) return 0xFFFD;
+            codepoint = (codepoint << 6) | (*p++ & 0x3F);
+        }
+        return codepoint;
+    }
+}
+
 // Shaders para renderizar texto (inline como strings para simplificar)
 const char* textVertexShaderSource = R"(
 #version 330 core
@@ -167,16 +184,27 @@ bool TextRender::loadCharacter(unsigned long codepoint) {
     return true;
 }
 
-void TextRender::renderText(const std::string& text, float x, float y, float scale, const glm::vec3& color) {
+glm::vec2 TextRender::measureText(std::string_view text, float scale) {
+    glm::vec2 extent(0.0f);
+    const unsigned char* cursor = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = cursor + text.size();
+    while (cursor != end) {
+        char32_t c = decodeUtf8(cursor, end);
+        if (!loadCharacter(c)) continue;
+        const Character& ch = Characters.find(c)->second;
+        extent.x += (ch.Advance >> 6) * scale;
+        extent.y = std::max(extent.y, ch.Size.y * scale);
+    }
+    return extent;
+}
+
+void TextRender::renderText(std::string_view text, float x, float y, float scale, const glm::vec3& color) {
+    PROFILE_ZONE("TextRender::renderText");
     if (!initialized) {
         std::cerr << "ERROR: TextRender not properly initialized" << std::endl;
         return;
     }
     
-    // Convertir string UTF-8 a codepoints Unicode
-    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
-    std::u32string utf32 = converter.from_bytes(text);
-    
     // Activar el shader para texto
     glUseProgram(shaderProgram);
     
@@ -197,13 +225,17 @@ void TextRender::renderText(const std::string& text, float x, float y, float sca
     
     // Iterar a través de todos los caracteres
     float x_pos = x;
-    for (char32_t c : utf32) {
+    // Decodificar UTF-8 sobre la marcha, sin copias temporales
+    const unsigned char* cursor = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = cursor + text.size();
+    while (cursor != end) {
+        char32_t c = decodeUtf8(cursor, end);
         // Cargar el carácter si es necesario
         if (!loadCharacter(c)) {
             continue; // Saltar si no se puede cargar
         }
         
-        Character ch = Characters[c];
+        const Character& ch = Characters.find(c)->second;
         
         float xpos = x_pos + ch.Bearing.x * scale;
         float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
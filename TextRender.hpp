@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -24,7 +25,10 @@ public:
     bool init();
     
     // Renders text on a specific position with a color and scale
-    void renderText(const std::string& text, float x, float y, float scale, const glm::vec3& color);
+    void renderText(std::string_view text, float x, float y, float scale, const glm::vec3& color);
+
+    // Width and height in pixels renderText would cover at this scale
+    glm::vec2 measureText(std::string_view text, float scale);
     
 private:
     FT_Library ft;
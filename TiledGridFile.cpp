@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "TiledGridFile.hpp"
+#include "ElectricField.hpp"
+#include "TaskScheduler.hpp"
+
+namespace {
+    const char fileMagic[8] = {'E', 'F', 'T', 'I', 'L', 'E', 'S', '\0'};
+    const uint32_t fileVersion = 1;
+    const uint32_t byteOrderMark = 0x01020304;   // Reads differently on the other endianness
+    const uint64_t headerBytes = 4096;
+    const uint64_t pageBytes = 4096;
+    const uint32_t maxTileSize = 65536;         // Keeps tileBytesFor from overflowing
+
+    // What is stored at the start of the header block
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t columns, rows;
+        uint32_t tileSize;
+        uint32_t channels;
+        uint32_t precision;
+        uint32_t reserved;
+        double xMin, xMax, yMin, yMax;
+        uint64_t tileBytes;
+    };
+    static_assert(sizeof(FileHeader) <= headerBytes, "header does not fit its block");
+
+    uint64_t tileBytesFor(uint32_t tileSize, uint32_t channels) {
+        uint64_t bytes = static_cast<uint64_t>(tileSize) * tileSize * channels * sizeof(float);
+        return (bytes + pageBytes - 1) / pageBytes * pageBytes;
+    }
+
+    double sampleStep(double min, double max, uint64_t count) {
+        return count > 1 ? (max - min) / static_cast<double>(count - 1) : 0.0;
+    }
+}
+
+bool TiledGridFile::write(const std::string& path, const ElectricField& field, const TiledGridLayout& layout) {
+    if (layout.columns == 0 || layout.rows == 0 || layout.tileSize == 0) {
+        std::cerr << "Tiled grid needs a size and a tile size" << std::endl;
+        return false;
+    }
+
+    uint32_t channels = layout.potential ? 3 : 2;
+    uint64_t tileSize = layout.tileSize;
+    uint64_t tileColumns = (layout.columns + tileSize - 1) / tileSize;
+    uint64_t tileRows = (layout.rows + tileSize - 1) / tileSize;
+    uint64_t tileBytes = tileBytesFor(layout.tileSize, channels);
+
+    MappedFile out;
+    if (!out.create(path, headerBytes + tileColumns * tileRows * tileBytes)) return false;
+    uint8_t* data = out.getWritableData();
+
+    FileHeader header = {};
+    std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.version = fileVersion;
+    header.byteOrder = byteOrderMark;
+    header.columns = layout.columns;
+    header.rows = layout.rows;
+    header.tileSize = layout.tileSize;
+    header.channels = channels;
+    header.precision = static_cast<uint32_t>(layout.precision);
+    header.xMin = layout.xMin;
+    header.xMax = layout.xMax;
+    header.yMin = layout.yMin;
+    header.yMax = layout.yMax;
+    header.tileBytes = tileBytes;
+    std::memcpy(data, &header, sizeof(header));
+
+    double dx = sampleStep(layout.xMin, layout.xMax, layout.columns);
+    double dy = sampleStep(layout.yMin, layout.yMax, layout.rows);
+
+    // One tile per task; each writes only its own pages of the mapping
+    TaskScheduler::global().parallelFor(0, tileColumns * tileRows, 1, [&](size_t begin, size_t end) {
+        std::vector<float> xs, ys, ex, ey, potential;
+        for (size_t t = begin; t < end; t++) {
+            uint64_t firstColumn = (t % tileColumns) * tileSize;
+            uint64_t firstRow = (t / tileColumns) * tileSize;
+            size_t columns = static_cast<size_t>(std::min(tileSize, layout.columns - firstColumn));
+            size_t rows = static_cast<size_t>(std::min(tileSize, layout.rows - firstRow));
+            size_t count = columns * rows;
+
+            xs.resize(count);
+            ys.resize(count);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < columns; c++) {
+                    xs[r * columns + c] = static_cast<float>(layout.xMin + (firstColumn + c) * dx);
+                    ys[r * columns + c] = static_cast<float>(layout.yMin + (firstRow + r) * dy);
+                }
+            }
+
+            ex.resize(count);
+            ey.resize(count);
+            field.getFieldAtBatch(xs.data(), ys.data(), count, ex.data(), ey.data(), layout.precision);
+            if (layout.potential) {
+                potential.resize(count);
+                field.getPotentialAtBatch(xs.data(), ys.data(), count, potential.data());
+            }
+
+            // Padding keeps the zeros of the freshly extended file
+            float* planes = reinterpret_cast<float*>(data + headerBytes + t * tileBytes);
+            size_t planeSize = static_cast<size_t>(tileSize * tileSize);
+            for (size_t r = 0; r < rows; r++) {
+                std::memcpy(planes + r * tileSize, ex.data() + r * columns, columns * sizeof(float));
+                std::memcpy(planes + planeSize + r * tileSize, ey.data() + r * columns, columns * sizeof(float));
+                if (layout.potential) {
+                    std::memcpy(planes + 2 * planeSize + r * tileSize, potential.data() + r * columns,
+                                columns * sizeof(float));
+                }
+            }
+        }
+    });
+
+    if (!out.flush()) {
+        std::cerr << "Could not write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TiledGridFile::open(const std::string& path) {
+    close();
+    if (!file.openRead(path)) return false;
+
+    FileHeader header;
+    if (file.getSize() < headerBytes) {
+        std::cerr << path << " is not a tiled grid (too short)" << std::endl;
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.getData(), sizeof(header));
+
+    if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0) {
+        std::cerr << path << " is not a tiled grid" << std::endl;
+        close();
+        return false;
+    }
+    if (header.version != fileVersion || header.byteOrder != byteOrderMark) {
+        std::cerr << path << ": unsupported version or byte order" << std::endl;
+        close();
+        return false;
+    }
+    // The tile size must be exactly what write() produces: a larger one
+    // would let the size computations below wrap around
+    if (header.columns == 0 || header.rows == 0 || header.tileSize == 0 || header.tileSize > maxTileSize
+        || (header.channels != 2 && header.channels != 3)
+        || header.precision > static_cast<uint32_t>(FieldPrecision::Double)
+        || header.tileBytes != tileBytesFor(header.tileSize, header.channels)) {
+        std::cerr << path << ": corrupt header" << std::endl;
+        close();
+        return false;
+    }
+
+    // Rounded up without header.columns + tileSize - 1, which can wrap
+    tileColumns = header.columns / header.tileSize + (header.columns % header.tileSize != 0);
+    tileRows = header.rows / header.tileSize + (header.rows % header.tileSize != 0);
+    tileBytes = header.tileBytes;
+    // Compared by division so a huge tile count cannot wrap the product
+    uint64_t tilesInFile = (file.getSize() - headerBytes) / tileBytes;
+    if (tileRows > tilesInFile / tileColumns) {
+        std::cerr << path << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+
+    layout.xMin = header.xMin;
+    layout.xMax = header.xMax;
+    layout.yMin = header.yMin;
+    layout.yMax = header.yMax;
+    layout.columns = header.columns;
+    layout.rows = header.rows;
+    layout.tileSize = header.tileSize;
+    layout.potential = header.channels == 3;
+    layout.precision = static_cast<FieldPrecision>(header.precision);
+    return true;
+}
+
+void TiledGridFile::close() {
+    file.close();
+    layout = TiledGridLayout();
+    tileColumns = tileRows = tileBytes = 0;
+}
+
+const float* TiledGridFile::plane(uint64_t tileColumn, uint64_t tileRow, int channel) const {
+    uint64_t offset = headerBytes + (tileRow * tileColumns + tileColumn) * tileBytes
+                    + static_cast<uint64_t>(channel) * layout.tileSize * layout.tileSize * sizeof(float);
+    return reinterpret_cast<const float*>(file.getData() + offset);
+}
+
+TiledGridFile::Tile TiledGridFile::getTile(uint64_t tileColumn, uint64_t tileRow) const {
+    Tile tile;
+    if (!isOpen() || tileColumn >= tileColumns || tileRow >= tileRows) return tile;
+
+    tile.firstColumn = tileColumn * layout.tileSize;
+    tile.firstRow = tileRow * layout.tileSize;
+    tile.columns = static_cast<size_t>(std::min<uint64_t>(layout.tileSize, layout.columns - tile.firstColumn));
+    tile.rows = static_cast<size_t>(std::min<uint64_t>(layout.tileSize, layout.rows - tile.firstRow));
+    tile.stride = layout.tileSize;
+    tile.ex = plane(tileColumn, tileRow, 0);
+    tile.ey = plane(tileColumn, tileRow, 1);
+    if (layout.potential) tile.potential = plane(tileColumn, tileRow, 2);
+    return tile;
+}
+
+glm::vec2 TiledGridFile::getField(uint64_t column, uint64_t row) const {
+    if (!isOpen() || column >= layout.columns || row >= layout.rows) return glm::vec2(0.0f);
+    uint64_t tileSize = layout.tileSize;
+    size_t index = static_cast<size_t>((row % tileSize) * tileSize + column % tileSize);
+    return glm::vec2(plane(column / tileSize, row / tileSize, 0)[index],
+                     plane(column / tileSize, row / tileSize, 1)[index]);
+}
+
+float TiledGridFile::getPotential(uint64_t column, uint64_t row) const {
+    if (!isOpen() || !layout.potential || column >= layout.columns || row >= layout.rows) return 0.0f;
+    uint64_t tileSize = layout.tileSize;
+    size_t index = static_cast<size_t>((row % tileSize) * tileSize + column % tileSize);
+    return plane(column / tileSize, row / tileSize, 2)[index];
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "MappedFile.hpp"
+#include "PreciseFieldKernels.hpp"
+
+class ElectricField;
+
+// Field grids too large for memory (65536 x 65536 and up), stored in
+// square tiles so a region can be read without touching the rest.
+//
+// File layout: a 4096-byte header, then the tiles row by row (tile
+// (tx, ty) is number ty * tileColumns + tx). A tile holds tileSize x
+// tileSize samples as one plane per channel (ex, ey, then the potential if
+// present), each row-major float32 in the machine's byte order; edge tiles
+// are padded with zeros. Every tile starts on a 4096-byte boundary, so a
+// tile maps to whole pages.
+// Sample (c, r) sits at x = xMin + c * (xMax - xMin) / (columns - 1), same
+// for y, as in efield_eval.
+struct TiledGridLayout {
+    double xMin = -1.0, xMax = 1.0, yMin = -1.0, yMax = 1.0;
+    uint64_t columns = 0, rows = 0;
+    uint32_t tileSize = 256;
+    bool potential = false;                          // Adds the potential channel
+    FieldPrecision precision = FieldPrecision::Float;  // How the field was summed
+};
+
+class TiledGridFile {
+public:
+    // One tile, pointing into the mapping (valid while the file is open)
+    struct Tile {
+        uint64_t firstColumn = 0, firstRow = 0;   // Grid sample of element (0, 0)
+        size_t columns = 0, rows = 0;             // Real samples; the rest is padding
+        size_t stride = 0;                        // Floats from one row to the next
+        const float* ex = nullptr;
+        const float* ey = nullptr;
+        const float* potential = nullptr;         // Null without the potential channel
+    };
+
+    // Evaluates the field over the layout and writes it to path. Tiles are
+    // computed in parallel straight into the mapped file, so memory use is
+    // bounded by the tiles in flight, not by the grid.
+    static bool write(const std::string& path, const ElectricField& field, const TiledGridLayout& layout);
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    const TiledGridLayout& getLayout() const { return layout; }
+    uint64_t getTileColumns() const { return tileColumns; }
+    uint64_t getTileRows() const { return tileRows; }
+
+    Tile getTile(uint64_t tileColumn, uint64_t tileRow) const;
+
+    // Single samples, for spot checks; stream tiles for anything bigger
+    glm::vec2 getField(uint64_t column, uint64_t row) const;
+    float getPotential(uint64_t column, uint64_t row) const;
+
+private:
+    MappedFile file;
+    TiledGridLayout layout;
+    uint64_t tileColumns = 0, tileRows = 0;
+    uint64_t tileBytes = 0;
+
+    const float* plane(uint64_t tileColumn, uint64_t tileRow, int channel) const;
+};
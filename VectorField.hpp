@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Non-owning view of a contiguous array (std::span is C++20)
+template <typename T>
+class Span {
+public:
+    Span() : first(nullptr), count(0) {}
+    Span(T* data, size_t size) : first(data), count(size) {}
+
+    template <typename U>
+    Span(std::vector<U>& values) : first(values.data()), count(values.size()) {}
+    template <typename U>
+    Span(const std::vector<U>& values) : first(values.data()), count(values.size()) {}
+
+    T* data() const { return first; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return first[i]; }
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+
+    // Elements [offset, offset + length)
+    Span subspan(size_t offset, size_t length) const { return Span(first + offset, length); }
+
+private:
+    T* first;
+    size_t count;
+};
+
+// A 2D vector field that is sampled a batch of points at a time.
+// One virtual call covers a whole row or tile; inside it the loop is
+// concrete code the compiler can inline and vectorise, which a
+// std::function called per point does not allow.
+class VectorField {
+public:
+    virtual ~VectorField() = default;
+
+    // Field at (xs[i], ys[i]) written to (ex[i], ey[i]); all four spans
+    // have the same size
+    virtual void sample(Span<const float> xs, Span<const float> ys, Span<float> ex, Span<float> ey) const = 0;
+
+    // Single point convenience (one batch of one)
+    glm::vec2 sampleAt(float x, float y) const {
+        glm::vec2 v;
+        sample(Span<const float>(&x, 1), Span<const float>(&y, 1), Span<float>(&v.x, 1), Span<float>(&v.y, 1));
+        return v;
+    }
+};
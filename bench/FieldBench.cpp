@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "AllocationTracker.hpp"
+#include "ChargeDynamics.hpp"
+#include "ElectricField.hpp"
+#include "FieldGrid.hpp"
+#include "FieldKernels.hpp"
+#include "Profiler.hpp"
+#include "TaskScheduler.hpp"
+#include "SceneGenerator.hpp"
+
+// Headless benchmark of the field code: builds seeded scenes, times grid
+// evaluation for every engine at a few resolutions (with each engine's
+// error against a double direct sum), picking and sensor queries, and
+// writes the results as JSON and CSV.
+// It also replays app-like frames (move a charge, sync the grid, pick,
+// read the sensor, take a dynamics step) and, in builds with EFIELD_TRACK_ALLOCATIONS, counts
+// their heap allocations; --fail-on-alloc turns any allocation in those
+// steady-state frames into a failing exit code.
+//
+//   efield_bench [--max-charges N] [--seed S] [--repeats R] [--budget B]
+//                [--json path] [--csv path] [--fail-on-alloc]
+
+namespace {
+    struct Options {
+        size_t maxCharges = 1000000;
+        uint32_t seed = 1;
+        int repeats = 3;
+        double budget = 4e9;          // Direct interactions allowed per timed run
+        std::string jsonPath = "efield_bench.json";
+        std::string csvPath = "efield_bench.csv";
+        bool failOnAllocation = false;
+    };
+
+    // Allocation counts of the steady-state frames
+    struct SteadyState {
+        uint64_t frames = 0;
+        uint64_t allocatingFrames = 0;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Result {
+        std::string scene;
+        size_t charges;
+        std::string benchmark;        // "grid", "pick", "sensor" or "frame"
+        std::string engine;
+        size_t resolution;            // Grid points per side, 0 for point queries
+        size_t samples;               // Grid points or queries per run, 0 for frames
+        int runs;
+        double medianMs;
+        double minMs;
+        double samplesPerSecond;      // From the median run, 0 for frames
+        double relativeError = -1.0;  // Relative L2 error of grid values, -1 if not measured
+    };
+
+    const size_t gridResolutions[] = {64, 256, 1024};
+    const size_t pickQueries = 100000;
+    const size_t minErrorPoints = 16;  // Grid points the error is measured on, at least
+    const double maxRunSeconds = 2.0;  // Stop repeating once a run takes this long
+
+    const size_t steadyCharges = 1000;
+    const size_t steadyResolution = 256;
+    const int warmupFrames = 10;       // Let caches and buffers reach their size
+    const int steadyFrames = 100;
+    const int draggedCharges = 4;      // Charges the steady frames take turns moving
+
+    const float boundsMin = -1.0f;
+    const float boundsMax = 1.0f;
+
+    const char* engineName(FieldEngine engine) {
+        switch (engine) {
+            case FieldEngine::Direct:    return "direct";
+            case FieldEngine::BarnesHut: return "barnes-hut";
+            case FieldEngine::Multipole: return "multipole";
+        }
+        return "unknown";
+    }
+
+    // Runs body() up to `repeats` times (at least once) and returns the
+    // sorted run times in milliseconds
+    template <typename Body>
+    std::vector<double> timeRuns(int repeats, Body body) {
+        std::vector<double> times;
+        for (int r = 0; r < repeats; r++) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto stop = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+            if (times.back() > maxRunSeconds * 1000.0) break;
+        }
+        std::sort(times.begin(), times.end());
+        return times;
+    }
+
+    Result makeResult(const Scene& scene, const char* benchmark, const char* engine,
+                      size_t resolution, size_t samples, const std::vector<double>& times) {
+        Result result;
+        result.scene = sceneKindName(scene.kind);
+        result.charges = scene.size();
+        result.benchmark = benchmark;
+        result.engine = engine;
+        result.resolution = resolution;
+        result.samples = samples;
+        result.runs = static_cast<int>(times.size());
+        result.medianMs = times[times.size() / 2];
+        result.minMs = times.front();
+        result.samplesPerSecond = result.medianMs > 0.0 ? samples / (result.medianMs / 1000.0) : 0.0;
+        return result;
+    }
+
+    void printResult(const Result& r) {
+        std::cout << "  " << r.benchmark << " " << r.engine;
+        if (r.resolution > 0) std::cout << " " << r.resolution << "x" << r.resolution;
+        if (r.samples == 0) {
+            std::cout << ": " << r.medianMs << " ms/frame (min " << r.minMs << ", " << r.runs << " frames)";
+        } else {
+            std::cout << ": " << r.medianMs << " ms (min " << r.minMs << ", " << r.runs << " runs), "
+                      << r.samplesPerSecond / 1e6 << " M/s";
+        }
+        if (r.relativeError >= 0.0) std::cout << ", rel. L2 error " << r.relativeError;
+        std::cout << std::endl;
+    }
+
+    // Grid points the engines' errors are measured on: every stride-th
+    // point, with the double direct sum there as the reference
+    struct ErrorReference {
+        size_t stride;
+        std::vector<float> ex, ey;
+    };
+
+    ErrorReference makeErrorReference(const ElectricField& field, const FieldGrid& grid, const Options& options) {
+        size_t points = grid.getColumnCount() * grid.getRowCount();
+        double perPoint = static_cast<double>(std::max<size_t>(field.getChargeStorage().size(), 1));
+        size_t wanted = static_cast<size_t>(std::max(static_cast<double>(minErrorPoints), options.budget / 100.0 / perPoint));
+
+        ErrorReference reference;
+        reference.stride = std::max<size_t>(1, points / std::max<size_t>(wanted, 1));
+        std::vector<float> xs, ys;
+        for (size_t i = 0; i < points; i += reference.stride) {
+            xs.push_back(grid.getColumns()[i / grid.getRowCount()]);
+            ys.push_back(grid.getRows()[i % grid.getRowCount()]);
+        }
+        reference.ex.resize(xs.size());
+        reference.ey.resize(xs.size());
+        field.getFieldAtBatch(xs.data(), ys.data(), xs.size(), reference.ex.data(), reference.ey.data(),
+                              FieldPrecision::Double);
+        return reference;
+    }
+
+    double relativeL2Error(const FieldGrid& grid, const ErrorReference& reference) {
+        double errorSquared = 0.0, referenceSquared = 0.0;
+        size_t rows = grid.getRowCount();
+        for (size_t k = 0; k < reference.ex.size(); k++) {
+            size_t i = k * reference.stride;
+            glm::vec2 value = grid.getField(i / rows, i % rows);
+            double dx = static_cast<double>(value.x) - reference.ex[k];
+            double dy = static_cast<double>(value.y) - reference.ey[k];
+            errorSquared += dx*dx + dy*dy;
+            referenceSquared += static_cast<double>(reference.ex[k]) * reference.ex[k]
+                              + static_cast<double>(reference.ey[k]) * reference.ey[k];
+        }
+        return referenceSquared > 0.0 ? std::sqrt(errorSquared / referenceSquared) : 0.0;
+    }
+
+    void benchGrid(ElectricField& field, const Scene& scene, const Options& options,
+                   std::vector<Result>& results) {
+        const FieldEngine engines[] = {FieldEngine::Direct, FieldEngine::BarnesHut, FieldEngine::Multipole};
+
+        for (size_t resolution : gridResolutions) {
+            FieldGrid grid;
+            grid.setLayout(boundsMin, boundsMax, boundsMin, boundsMax,
+                           (boundsMax - boundsMin) / static_cast<float>(resolution - 1));
+            size_t points = grid.getColumnCount() * grid.getRowCount();
+            ErrorReference reference = makeErrorReference(field, grid, options);
+
+            for (FieldEngine engine : engines) {
+                if (engine == FieldEngine::Direct &&
+                    static_cast<double>(points) * scene.size() > options.budget) {
+                    std::cout << "  grid " << engineName(engine) << " " << resolution << "x" << resolution
+                              << ": skipped (over the interaction budget)" << std::endl;
+                    continue;
+                }
+
+                // Re-selecting the engine is a structural change, so every
+                // sync is a full recomputation including the tree build
+                std::vector<double> times = timeRuns(options.repeats, [&]() {
+                    field.setEngine(engine);
+                    grid.sync(field);
+                });
+                results.push_back(makeResult(scene, "grid", engineName(engine), resolution, points, times));
+                results.back().relativeError = relativeL2Error(grid, reference);
+                printResult(results.back());
+            }
+        }
+        field.setEngine(FieldEngine::Direct);
+    }
+
+    void benchPicking(const ElectricField& field, const Scene& scene, const Options& options,
+                      std::vector<Result>& results) {
+        std::mt19937 rng(options.seed);
+        std::uniform_real_distribution<float> coordinate(boundsMin, boundsMax);
+        std::vector<float> xs(pickQueries), ys(pickQueries);
+        for (size_t i = 0; i < pickQueries; i++) {
+            xs[i] = coordinate(rng);
+            ys[i] = coordinate(rng);
+        }
+
+        long long hits = 0;
+        std::vector<double> times = timeRuns(options.repeats, [&]() {
+            for (size_t i = 0; i < pickQueries; i++) {
+                hits += field.findChargeAt(xs[i], ys[i]) >= 0;
+            }
+        });
+        results.push_back(makeResult(scene, "pick", "hash", 0, pickQueries, times));
+        printResult(results.back());
+        if (hits < 0) std::cout << hits << std::endl;   // Keeps the loop from being optimised away
+    }
+
+    // Single-point queries the way the sensor makes them: direct sum in double
+    void benchSensor(const ElectricField& field, const Scene& scene, const Options& options,
+                     std::vector<Result>& results) {
+        double perQuery = static_cast<double>(std::max<size_t>(scene.size(), 1));
+        size_t queries = static_cast<size_t>(std::min(10000.0, std::max(16.0, options.budget / 20.0 / perQuery)));
+
+        std::mt19937 rng(options.seed + 1);
+        std::uniform_real_distribution<float> coordinate(boundsMin, boundsMax);
+        std::vector<float> xs(queries), ys(queries);
+        for (size_t i = 0; i < queries; i++) {
+            xs[i] = coordinate(rng);
+            ys[i] = coordinate(rng);
+        }
+
+        float sink = 0.0f;
+        std::vector<double> times = timeRuns(options.repeats, [&]() {
+            for (size_t i = 0; i < queries; i++) {
+                sink += field.getFieldAt(xs[i], ys[i], FieldPrecision::Double).x;
+            }
+        });
+        results.push_back(makeResult(scene, "sensor", "direct-double", 0, queries, times));
+        printResult(results.back());
+        if (sink == 12345.0f) std::cout << sink << std::endl;
+    }
+
+    // Frames shaped like the app's: a dragged charge moves (incremental grid
+    // update), then a pick and a sensor reading. A few charges take turns so
+    // the warm-up has moved each of them before the measured frames. Each
+    // frame also takes one step of a free-running simulation on a second
+    // copy of the scene (its own field keeps the grid on the incremental
+    // path), so the per-step path (forces, setPositions, index rebuild) is
+    // covered too, with the charges drifting into cells the warm-up never saw.
+    SteadyState benchSteadyFrames(const SceneGenerator& generator, std::vector<Result>& results) {
+        Scene scene = generator.generate(SceneKind::Uniform, steadyCharges);
+        ElectricField field;
+        for (size_t i = 0; i < scene.size(); i++) {
+            field.addCharge(scene.x[i], scene.y[i], scene.q[i]);
+        }
+
+        FieldGrid grid;
+        grid.setLayout(boundsMin, boundsMax, boundsMin, boundsMax,
+                       (boundsMax - boundsMin) / static_cast<float>(steadyResolution - 1));
+
+        ElectricField movingField;
+        for (size_t i = 0; i < scene.size(); i++) {
+            movingField.addCharge(scene.x[i], scene.y[i], scene.q[i]);
+        }
+        ChargeDynamics dynamics;
+
+        float sink = 0.0f;
+        auto frame = [&](int f) {
+            PROFILE_ZONE("Bench frame");
+            int index = (f % draggedCharges) * static_cast<int>(scene.size()) / draggedCharges;
+            float offset = (f & 1) ? 0.01f : -0.01f;
+            field.moveCharge(index, scene.x[index] + offset, scene.y[index]);
+            grid.sync(field);
+            sink += static_cast<float>(field.findChargeAt(scene.x[index], scene.y[index]));
+            sink += field.getFieldAt(0.5f, 0.5f, FieldPrecision::Double).x;
+            dynamics.advance(movingField, dynamics.getTimeStep());
+        };
+
+        // Reserved before the warm-up so it is not counted against a frame
+        std::vector<double> times;
+        times.reserve(steadyFrames);
+
+        for (int f = 0; f < warmupFrames; f++) {
+            frame(f);
+            Profiler::global().endFrame();
+            AllocationTracker::endFrame();
+        }
+        AllocationTracker::resetTotals();
+
+        SteadyState state;
+        for (int f = warmupFrames; f < warmupFrames + steadyFrames; f++) {
+            auto start = std::chrono::steady_clock::now();
+            frame(f);
+            auto stop = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+
+            Profiler::global().endFrame();
+            AllocationTracker::endFrame();
+            AllocationTracker::Counts counts = AllocationTracker::getLastFrame();
+            state.allocations += counts.allocations;
+            state.bytes += counts.bytes;
+        }
+        state.frames = AllocationTracker::getFrameCount();
+        state.allocatingFrames = AllocationTracker::getAllocatingFrameCount();
+        if (sink == 12345.0f) std::cout << sink << std::endl;
+
+        std::sort(times.begin(), times.end());
+        // A frame is not a batch of samples: ms per frame only
+        results.push_back(makeResult(scene, "frame", "direct", steadyResolution, 0, times));
+        std::cout << "steady-state frames, " << scene.size() << " charges" << std::endl;
+        printResult(results.back());
+        return state;
+    }
+
+    bool writeJson(const std::string& path, const Options& options, const std::vector<Result>& results,
+                   const SteadyState& steady) {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        out << "{\n";
+        out << "  \"seed\": " << options.seed << ",\n";
+        out << "  \"threads\": " << TaskScheduler::global().getThreadCount() << ",\n";
+        out << "  \"kernel\": \"" << fieldKernelName() << "\",\n";
+        out << "  \"allocation_tracking\": " << (AllocationTracker::enabled() ? "true" : "false") << ",\n";
+        out << "  \"steady_state\": {\"frames\": " << steady.frames
+            << ", \"allocating_frames\": " << steady.allocatingFrames
+            << ", \"allocations\": " << steady.allocations << ", \"bytes\": " << steady.bytes << "},\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << "    {\"scene\": \"" << r.scene << "\", \"charges\": " << r.charges
+                << ", \"benchmark\": \"" << r.benchmark << "\", \"engine\": \"" << r.engine
+                << "\", \"resolution\": " << r.resolution << ", \"samples\": " << r.samples
+                << ", \"runs\": " << r.runs << ", \"median_ms\": " << r.medianMs
+                << ", \"min_ms\": " << r.minMs << ", \"samples_per_second\": ";
+            if (r.samples > 0) out << r.samplesPerSecond; else out << "null";
+            out << ", \"relative_error\": ";
+            if (r.relativeError >= 0.0) out << r.relativeError; else out << "null";
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    bool writeCsv(const std::string& path, const std::vector<Result>& results) {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        // Fields that do not apply (throughput of a frame, error of a query) are empty
+        out << "scene,charges,benchmark,engine,resolution,samples,runs,median_ms,min_ms,samples_per_second,"
+               "relative_error\n";
+        for (const Result& r : results) {
+            out << r.scene << "," << r.charges << "," << r.benchmark << "," << r.engine << ","
+                << r.resolution << "," << r.samples << "," << r.runs << "," << r.medianMs << ","
+                << r.minMs << ",";
+            if (r.samples > 0) out << r.samplesPerSecond;
+            out << ",";
+            if (r.relativeError >= 0.0) out << r.relativeError;
+            out << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+            if (std::strcmp(arg, "--help") == 0) {
+                return false;
+            }
+            if (std::strcmp(arg, "--fail-on-alloc") == 0) {
+                options.failOnAllocation = true;
+                continue;
+            }
+            if (!value) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+
+            if (std::strcmp(arg, "--max-charges") == 0) {
+                options.maxCharges = std::strtoull(value, nullptr, 10);
+            } else if (std::strcmp(arg, "--seed") == 0) {
+                options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            } else if (std::strcmp(arg, "--repeats") == 0) {
+                options.repeats = std::max(1, std::atoi(value));
+            } else if (std::strcmp(arg, "--budget") == 0) {
+                options.budget = std::strtod(value, nullptr);
+            } else if (std::strcmp(arg, "--json") == 0) {
+                options.jsonPath = value;
+            } else if (std::strcmp(arg, "--csv") == 0) {
+                options.csvPath = value;
+            } else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return false;
+            }
+            i++;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: efield_bench [--max-charges N] [--seed S] [--repeats R] [--budget B]"
+                     " [--json path] [--csv path] [--fail-on-alloc]" << std::endl;
+        return 1;
+    }
+    if (options.failOnAllocation && !AllocationTracker::enabled()) {
+        std::cerr << "--fail-on-alloc needs a build with EFIELD_TRACK_ALLOCATIONS" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Field kernel: " << fieldKernelName()
+              << ", threads: " << TaskScheduler::global().getThreadCount()
+              << ", seed: " << options.seed << std::endl;
+
+    SceneGenerator generator(options.seed);
+    generator.setBounds(boundsMin, boundsMax, boundsMin, boundsMax);
+
+    const SceneKind kinds[] = {SceneKind::Uniform, SceneKind::Clustered, SceneKind::DipoleLattice};
+    std::vector<Result> results;
+
+    for (size_t count = 10; count <= options.maxCharges; count *= 10) {
+        for (SceneKind kind : kinds) {
+            Scene scene = generator.generate(kind, count);
+            std::cout << sceneKindName(kind) << ", " << scene.size() << " charges" << std::endl;
+
+            ElectricField field;
+            for (size_t i = 0; i < scene.size(); i++) {
+                field.addCharge(scene.x[i], scene.y[i], scene.q[i]);
+            }
+
+            benchGrid(field, scene, options, results);
+            benchPicking(field, scene, options, results);
+            benchSensor(field, scene, options, results);
+        }
+    }
+
+    SteadyState steady = benchSteadyFrames(generator, results);
+    if (AllocationTracker::enabled()) {
+        std::cout << "  " << steady.allocatingFrames << " of " << steady.frames << " frames allocated ("
+                  << steady.allocations << " allocations, " << steady.bytes << " bytes)" << std::endl;
+        if (steady.allocatingFrames > 0) AllocationTracker::report(std::cout);
+    }
+
+    bool ok = true;
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, results, steady)) {
+        std::cerr << "Could not write " << options.jsonPath << std::endl;
+        ok = false;
+    }
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, results)) {
+        std::cerr << "Could not write " << options.csvPath << std::endl;
+        ok = false;
+    }
+    if (!ok) return 1;
+
+    if (options.failOnAllocation && steady.allocatingFrames > 0) {
+        std::cerr << "FAIL: steady-state frames allocated" << std::endl;
+        return 2;
+    }
+    return 0;
+}
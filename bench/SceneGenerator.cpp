@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "SceneGenerator.hpp"
+
+namespace {
+    const float minMagnitude = 0.5f;   // Charge values are +-[0.5, 2]
+    const float maxMagnitude = 2.0f;
+
+    // [0, 1) from the top 24 bits, identical on every platform
+    float unit(std::mt19937& rng) {
+        return static_cast<float>(rng() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float between(std::mt19937& rng, float lo, float hi) {
+        return lo + (hi - lo) * unit(rng);
+    }
+
+    // Box-Muller; one of the pair is dropped to keep the stream simple
+    float normal(std::mt19937& rng) {
+        float u = 1.0f - unit(rng);   // (0, 1], log stays finite
+        float v = unit(rng);
+        return std::sqrt(-2.0f * std::log(u)) * std::cos(2.0f * static_cast<float>(M_PI) * v);
+    }
+
+    float signedCharge(std::mt19937& rng) {
+        float magnitude = between(rng, minMagnitude, maxMagnitude);
+        return (rng() & 1u) ? magnitude : -magnitude;
+    }
+}
+
+void SceneGenerator::setBounds(float newXMin, float newXMax, float newYMin, float newYMax) {
+    xMin = std::min(newXMin, newXMax);
+    xMax = std::max(newXMin, newXMax);
+    yMin = std::min(newYMin, newYMax);
+    yMax = std::max(newYMin, newYMax);
+}
+
+Scene SceneGenerator::generate(SceneKind kind, size_t count) const {
+    Scene scene;
+    scene.kind = kind;
+    scene.seed = seed;
+    scene.x.reserve(count + 1);
+    scene.y.reserve(count + 1);
+    scene.q.reserve(count + 1);
+
+    switch (kind) {
+        case SceneKind::Uniform:       uniform(scene, count); break;
+        case SceneKind::Clustered:     clustered(scene, count); break;
+        case SceneKind::DipoleLattice: dipoleLattice(scene, count); break;
+    }
+    return scene;
+}
+
+void SceneGenerator::uniform(Scene& scene, size_t count) const {
+    // Kind and count go into the seed so every scene has its own stream
+    std::seed_seq sequence{seed, 1u, static_cast<uint32_t>(count)};
+    std::mt19937 rng(sequence);
+
+    for (size_t i = 0; i < count; i++) {
+        scene.x.push_back(between(rng, xMin, xMax));
+        scene.y.push_back(between(rng, yMin, yMax));
+        scene.q.push_back(signedCharge(rng));
+    }
+}
+
+void SceneGenerator::clustered(Scene& scene, size_t count) const {
+    std::seed_seq sequence{seed, 2u, static_cast<uint32_t>(count)};
+    std::mt19937 rng(sequence);
+
+    // About sqrt(N) / 8 blobs, each of one sign, so the field has large
+    // dense regions and empty space between them
+    size_t clusterCount = static_cast<size_t>(std::lround(std::sqrt(static_cast<double>(count)) / 8.0));
+    clusterCount = std::min<size_t>(std::max<size_t>(clusterCount, 1), 256);
+
+    float extent = std::min(xMax - xMin, yMax - yMin);
+    std::vector<float> centerX(clusterCount), centerY(clusterCount), spread(clusterCount), sign(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        centerX[c] = between(rng, xMin, xMax);
+        centerY[c] = between(rng, yMin, yMax);
+        spread[c] = extent * between(rng, 0.01f, 0.05f);
+        sign[c] = (rng() & 1u) ? 1.0f : -1.0f;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        size_t c = i % clusterCount;
+        float x = centerX[c] + spread[c] * normal(rng);
+        float y = centerY[c] + spread[c] * normal(rng);
+        scene.x.push_back(std::min(std::max(x, xMin), xMax));
+        scene.y.push_back(std::min(std::max(y, yMin), yMax));
+        scene.q.push_back(sign[c] * between(rng, minMagnitude, maxMagnitude));
+    }
+}
+
+void SceneGenerator::dipoleLattice(Scene& scene, size_t count) const {
+    size_t pairs = (count + 1) / 2;
+    if (pairs == 0) return;
+
+    // Square-ish cells over the bounds, one dipole in the middle of each
+    float width = xMax - xMin;
+    float height = yMax - yMin;
+    size_t columns = static_cast<size_t>(std::ceil(std::sqrt(pairs * width / std::max(height, 1e-6f))));
+    columns = std::max<size_t>(columns, 1);
+    size_t rows = (pairs + columns - 1) / columns;
+    float cellWidth = width / columns;
+    float cellHeight = height / rows;
+    float halfSeparation = 0.15f * std::min(cellWidth, cellHeight);
+
+    for (size_t p = 0; p < pairs; p++) {
+        size_t column = p % columns;
+        size_t row = p / columns;
+        float cx = xMin + (column + 0.5f) * cellWidth;
+        float cy = yMin + (row + 0.5f) * cellHeight;
+
+        // Checkerboard of horizontal and vertical dipoles
+        bool horizontal = ((column + row) & 1) == 0;
+        float dx = horizontal ? halfSeparation : 0.0f;
+        float dy = horizontal ? 0.0f : halfSeparation;
+
+        scene.x.push_back(cx - dx);
+        scene.y.push_back(cy - dy);
+        scene.q.push_back(1.0f);
+        scene.x.push_back(cx + dx);
+        scene.y.push_back(cy + dy);
+        scene.q.push_back(-1.0f);
+    }
+}
+
+const char* sceneKindName(SceneKind kind) {
+    switch (kind) {
+        case SceneKind::Uniform:       return "uniform";
+        case SceneKind::Clustered:     return "clustered";
+        case SceneKind::DipoleLattice: return "dipoles";
+    }
+    return "unknown";
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Layout of the generated charges
+enum class SceneKind {
+    Uniform,       // Positions and values spread evenly over the bounds
+    Clustered,     // Gaussian blobs of same-sign charges around random centres
+    DipoleLattice  // Regular grid of +q/-q pairs with alternating orientation
+};
+
+// A charge scene as structure-of-arrays, ready to be added to a field
+struct Scene {
+    SceneKind kind = SceneKind::Uniform;
+    uint32_t seed = 0;
+    std::vector<float> x, y, q;
+
+    size_t size() const { return q.size(); }
+};
+
+// Builds reproducible scenes: the same kind, count, seed and bounds always
+// give the same charges (std::mt19937 with our own distributions, so the
+// output does not depend on the standard library).
+class SceneGenerator {
+public:
+    explicit SceneGenerator(uint32_t seed = 1) : seed(seed) {}
+
+    // Charges are placed inside [xMin, xMax] x [yMin, yMax]
+    void setBounds(float newXMin, float newXMax, float newYMin, float newYMax);
+
+    // count charges of the given kind (a dipole lattice rounds count up to even)
+    Scene generate(SceneKind kind, size_t count) const;
+
+private:
+    uint32_t seed;
+    float xMin = -1.0f, xMax = 1.0f, yMin = -1.0f, yMax = 1.0f;
+
+    void uniform(Scene& scene, size_t count) const;
+    void clustered(Scene& scene, size_t count) const;
+    void dipoleLattice(Scene& scene, size_t count) const;
+};
+
+// Short lower-case name for reports ("uniform", "clustered", "dipoles")
+const char* sceneKindName(SceneKind kind);
@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+#include <cstdio>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -14,10 +16,25 @@
 
 #include "Arrow.hpp"
 #include "ElectricField.hpp"
+#include "FieldKernels.hpp"
 #include "ChargeRenderer.hpp"
 #include "TextRender.hpp"
 #include "Menu.hpp"
 #include "Sensor.hpp"
+#include "TaskScheduler.hpp"
+#include "FieldGrid.hpp"
+#include "AdaptiveSampler.hpp"
+#include "Camera.hpp"
+#include "Equipotentials.hpp"
+#include "LineRenderer.hpp"
+#include "FieldLines.hpp"
+#include "ChargeDynamics.hpp"
+#include "Profiler.hpp"
+#include "GpuTimer.hpp"
+#include "AllocationTracker.hpp"
+#include "FrameArena.hpp"
+#include "SceneIO.hpp"
+#include "SourceRenderer.hpp"
 
 
 //todo: Add charge values text into the charge
@@ -33,6 +50,7 @@ float fps = 0.0f;
 
 //Global variables for the menu
 bool showMenu = false;
+std::string sceneFile = "scene.efs";   // Save/load target of the menu
 Menu* mainMenu = nullptr;
 int menuOption;
 
@@ -44,6 +62,34 @@ int selectedChargeIndex = -1;
 Sensor* fieldSensor = nullptr;
 bool draggingSensor = false;
 
+// Global variables for the view: right button drags it, the wheel zooms
+Camera camera;
+bool panningView = false;
+glm::vec2 panAnchor(0.0f);     // World point held under the cursor while panning
+
+// Hit radius for charges and the sensor: 0.1 world units at zoom 1, the
+// same on screen at any zoom
+float pickRadius() {
+    return 0.1f / camera.getZoom();
+}
+
+// Global variable for the equipotential overlay
+bool showEquipotentials = false;
+
+// Global variable for the field line overlay
+bool showFieldLines = false;
+
+// Global variable for the dynamics mode (charges move under their own forces)
+bool runDynamics = false;
+
+// Global variable for the per-zone timing overlay
+bool showProfiler = false;
+
+// Global variable for the arrow layout: the cached grid, updated by deltas,
+// or the adaptive quadtree, which resamples everything whenever the field
+// changes and so is opt-in
+bool adaptiveArrows = false;
+
 
 // Window resizing callback
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
@@ -119,17 +165,88 @@ GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath) {
     return program;
 }
 
-// Directional field define function
-using VectorField = std::function<glm::vec2(float, float)>;
-
 // Rotational field example: (-y, x)
-glm::vec2 rotationalField(float x, float y) {
-    return glm::vec2(-y, x);
-}
+class RotationalField : public VectorField {
+public:
+    void sample(Span<const float> xs, Span<const float> ys, Span<float> ex, Span<float> ey) const override {
+        for (size_t i = 0; i < xs.size(); i++) {
+            ex[i] = -ys[i];
+            ey[i] = xs[i];
+        }
+    }
+};
 
 // Directional field example for dy/dx = cos(y)
-glm::vec2 cosineField(float x, float y) {
-    return glm::vec2(1.0f, cos(y));
+class CosineField : public VectorField {
+public:
+    void sample(Span<const float> xs, Span<const float> ys, Span<float> ex, Span<float> ey) const override {
+        for (size_t i = 0; i < xs.size(); i++) {
+            ex[i] = 1.0f;
+            ey[i] = std::cos(ys[i]);
+        }
+    }
+};
+
+// One tile of the arrow grid: a range of columns computed as a single task
+struct GridTile {
+    size_t columnBegin = 0;
+    size_t columnEnd = 0;
+    float arrowScale = 1.0f;
+    const VectorField* vectorField = nullptr;
+    std::vector<float> sampleX, sampleY, fieldX, fieldY;
+    std::vector<ArrowInstance> arrows;
+};
+
+// Arrow for a field value: length on a log scale to handle the wide range of
+// magnitudes (times scale), colour from blue at 0 to red at |E| = 1000
+ArrowInstance makeArrow(glm::vec2 position, glm::vec2 field, float scale) {
+    float magnitude = glm::length(field);
+    if (magnitude == 0.0f) return ArrowInstance{position, glm::vec2(1.0f, 0.0f), 0.0f, 0.0f};
+    float logMagnitude = std::log(1.0f + magnitude);
+    return ArrowInstance{position, field / magnitude, (0.05f + 0.025f * logMagnitude) * scale,
+                         std::min(logMagnitude / std::log(1001.0f), 1.0f)};
+}
+
+// Fills a tile's arrows: skips points near charges, takes the field from the
+// cached grid (or from vectorField if one is set) and scales it
+void computeGridTile(GridTile& tile, const FieldGrid& grid, const ElectricField& field) {
+    PROFILE_ZONE("Grid tile");
+    const VectorField* vectorField = tile.vectorField;
+    tile.sampleX.clear();
+    tile.sampleY.clear();
+    tile.fieldX.clear();
+    tile.fieldY.clear();
+    tile.arrows.clear();
+
+    for (size_t c = tile.columnBegin; c < tile.columnEnd; c++) {
+        float x = grid.getColumns()[c];
+        for (size_t r = 0; r < grid.getRowCount(); r++) {
+            float y = grid.getRows()[r];
+
+            // Skip points very close to charges to avoid extreme vectors
+            if (field.hasChargeWithin(x, y, 0.1f)) continue;
+            
+            tile.sampleX.push_back(x);
+            tile.sampleY.push_back(y);
+            if (!vectorField) {
+                glm::vec2 cached = grid.getField(c, r);
+                tile.fieldX.push_back(cached.x);
+                tile.fieldY.push_back(cached.y);
+            }
+        }
+    }
+
+    // Get vector field directions for the whole tile in one call
+    if (vectorField) {
+        tile.fieldX.resize(tile.sampleX.size());
+        tile.fieldY.resize(tile.sampleY.size());
+        vectorField->sample(tile.sampleX, tile.sampleY, tile.fieldX, tile.fieldY);
+    }
+
+    for (size_t i = 0; i < tile.sampleX.size(); ++i) {
+        tile.arrows.push_back(makeArrow(glm::vec2(tile.sampleX[i], tile.sampleY[i]),
+                                        glm::vec2(tile.fieldX[i], tile.fieldY[i]), tile.arrowScale));
+    }
 }
 
 // Function to set up some test electric charges
@@ -162,30 +279,28 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
 ElectricField electricField;
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
-    // Get cursor position
+    // Get cursor position in world coordinates
     double xpos, ypos;
     glfwGetCursorPos(window, &xpos, &ypos);
-    
-    // Convert screen coordinates to world coordinates
-    int width, height;
-    glfwGetWindowSize(window, &width, &height);
-    float aspectRatio = (float)width / (float)height;
-    
-    // Map from screen to world coordinates
-    float worldX = (2.0f * xpos / width - 1.0f) * (aspectRatio >= 1.0f ? aspectRatio : 1.0f);
-    float worldY = -(2.0f * ypos / height - 1.0f) * (aspectRatio < 1.0f ? 1.0f / aspectRatio : 1.0f);
+    glm::vec2 world = camera.cursorToWorld(xpos, ypos);
+    float worldX = world.x;
+    float worldY = world.y;
     
     if (showMenu) {
         mainMenu->processMouseClick(button, action);
     } else {
+        if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+            panningView = action == GLFW_PRESS;
+            panAnchor = world;
+        }
         if (button == GLFW_MOUSE_BUTTON_LEFT) {
             if (action == GLFW_PRESS) {
                 // First check if sensor is clicked (sensor has priority)
-                if (fieldSensor && fieldSensor->isActive() && fieldSensor->isPointOnSensor(worldX, worldY)) {
+                if (fieldSensor && fieldSensor->isActive() && fieldSensor->isPointOnSensor(worldX, worldY, pickRadius())) {
                     draggingSensor = true;
                 } else {
                     // Then check charges
-                    selectedChargeIndex = electricField.findChargeAt(worldX, worldY);
+                    selectedChargeIndex = electricField.findChargeAt(worldX, worldY, pickRadius());
                     if (selectedChargeIndex >= 0) {
                         draggingCharge = true;
                     }
@@ -200,14 +315,15 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 }
 
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
+    // Keep the grabbed point under the cursor while panning
+    if (panningView) {
+        camera.setCenter(camera.getCenter() + panAnchor - camera.cursorToWorld(xpos, ypos));
+    }
+
     // Convert screen coordinates to world coordinates
-    int width, height;
-    glfwGetWindowSize(window, &width, &height);
-    float aspectRatio = (float)width / (float)height;
-    
-    // Map from screen to world coordinates
-    float worldX = (2.0f * xpos / width - 1.0f) * (aspectRatio >= 1.0f ? aspectRatio : 1.0f);
-    float worldY = -(2.0f * ypos / height - 1.0f) * (aspectRatio < 1.0f ? 1.0f / aspectRatio : 1.0f);
+    glm::vec2 world = camera.cursorToWorld(xpos, ypos);
+    float worldX = world.x;
+    float worldY = world.y;
     
     if (showMenu) {
         mainMenu->processMouseMovement(xpos, ypos);
@@ -229,15 +345,111 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
     }
 
     if (!draggingSensor) {
-        selectedChargeIndex = electricField.findChargeAt(worldX, worldY);
+        selectedChargeIndex = electricField.findChargeAt(worldX, worldY, pickRadius());
     }
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-    if (yoffset != 0 && selectedChargeIndex >= 0 ) electricField.changeChargeSize(selectedChargeIndex, yoffset);
+    if (yoffset == 0) return;
+    // Over a charge the wheel changes its size, elsewhere it zooms at the cursor
+    if (selectedChargeIndex >= 0) {
+        electricField.changeChargeSize(selectedChargeIndex, yoffset);
+    } else {
+        double xpos, ypos;
+        glfwGetCursorPos(window, &xpos, &ypos);
+        glm::vec2 screen(static_cast<float>(xpos), static_cast<float>(camera.getViewportHeight() - ypos));
+        camera.zoomAt(screen, std::pow(1.1f, static_cast<float>(yoffset)));
+    }
     //std::cout << yoffset << std::endl;
 }
 
+// Prints the throughput and error of each precision mode for the current
+// charges, on a grid of points over the default view. The reference is a
+// long double direct sum with the same softening, and every row is a direct
+// sum too (the float row skips the active engine), so the rows differ only
+// in how they accumulate. The continuous sources are left out on both
+// sides: they are summed the same way in every mode.
+void reportFieldPrecision(const ElectricField& field) {
+    const ChargeStorage& charges = field.getChargeStorage();
+    if (charges.size() == 0) {
+        std::cout << "Precision report: no charges" << std::endl;
+        return;
+    }
+
+    // Keep the long double reference to a fraction of a second
+    size_t side = 64;
+    while (side > 8 && side * side * charges.size() > 20000000) side /= 2;
+
+    std::vector<float> xs, ys;
+    for (size_t i = 0; i < side; i++) {
+        for (size_t j = 0; j < side; j++) {
+            xs.push_back(-1.0f + (i + 0.5f) * 2.0f / side);
+            ys.push_back(-1.0f + (j + 0.5f) * 2.0f / side);
+        }
+    }
+    size_t n = xs.size();
+
+    const long double eps2 = 0.01L;
+    SofteningMode softening = field.getSofteningMode();
+    std::vector<long double> refX(n, 0.0L), refY(n, 0.0L);
+    for (size_t t = 0; t < n; t++) {
+        for (size_t i = 0; i < charges.size(); i++) {
+            long double rx = static_cast<long double>(xs[t]) - charges.x[i];
+            long double ry = static_cast<long double>(ys[t]) - charges.y[i];
+            long double d2 = rx*rx + ry*ry;
+            if (d2 == 0.0L) continue;   // The kernels skip a point on a charge
+            if (softening == SofteningMode::HardCutoff && d2 < eps2) continue;
+            if (softening == SofteningMode::Plummer) d2 += eps2;
+            long double scale = charges.q[i] / (d2 * std::sqrt(d2));
+            refX[t] += scale * rx;
+            refY[t] += scale * ry;
+        }
+    }
+
+    std::cout << "Precision report (" << charges.size() << " charges, " << n << " points"
+              << (field.getSources().empty() ? "" : ", point charges only") << ")" << std::endl;
+    std::vector<float> ex(n), ey(n);
+    for (FieldPrecision precision : {FieldPrecision::Float, FieldPrecision::Compensated, FieldPrecision::Double}) {
+        double start = glfwGetTime();
+        if (precision == FieldPrecision::Float) {
+            // The direct engine's float kernels, whatever engine is active
+            if (softening == SofteningMode::HardCutoff) {
+                computeFieldBatch(charges.x.data(), charges.y.data(), charges.q.data(), charges.size(),
+                                  xs.data(), ys.data(), n, ex.data(), ey.data(), static_cast<float>(eps2));
+            } else {
+                computeFieldBatchWithMode(softening, charges.x.data(), charges.y.data(), charges.q.data(),
+                                          charges.size(), xs.data(), ys.data(), n, ex.data(), ey.data(),
+                                          static_cast<float>(eps2));
+            }
+        } else {
+            computeFieldBatchPrecise(precision, softening, charges.x.data(), charges.y.data(), charges.q.data(),
+                                     charges.size(), xs.data(), ys.data(), n, ex.data(), ey.data(),
+                                     static_cast<float>(eps2));
+        }
+        double seconds = glfwGetTime() - start;
+
+        long double errorSquared = 0.0L, referenceSquared = 0.0L;
+        double worst = 0.0;
+        for (size_t t = 0; t < n; t++) {
+            long double dx = ex[t] - refX[t];
+            long double dy = ey[t] - refY[t];
+            long double reference = refX[t]*refX[t] + refY[t]*refY[t];
+            errorSquared += dx*dx + dy*dy;
+            referenceSquared += reference;
+            if (reference > 0.0L) {
+                worst = std::max(worst, static_cast<double>(std::sqrt((dx*dx + dy*dy) / reference)));
+            }
+        }
+
+        double interactions = static_cast<double>(n) * charges.size();
+        std::cout << "  " << std::setw(12) << std::left << fieldPrecisionName(precision) << std::right
+                  << std::setw(10) << std::fixed << std::setprecision(1) << interactions / seconds / 1e6 << " M interactions/s"
+                  << "   rel. L2 error " << std::scientific << std::setprecision(2)
+                  << static_cast<double>(std::sqrt(errorSquared / referenceSquared))
+                  << "   max rel. error " << worst << std::defaultfloat << std::endl;
+    }
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         showMenu = !showMenu;
@@ -256,6 +468,55 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             if (key == GLFW_KEY_UP) mainMenu -> switchOptionUp(key, action);
         }
     }
+    // Accuracy knob of the current engine: [ more accurate, ] faster
+    if ((key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET) && action == GLFW_PRESS) {
+        bool faster = key == GLFW_KEY_RIGHT_BRACKET;
+        if (electricField.getEngine() == FieldEngine::Multipole) {
+            electricField.setMultipoleOrder(electricField.getMultipoleOrder() + (faster ? -1 : 1));
+            std::cout << "Multipole order: " << electricField.getMultipoleOrder() << std::endl;
+        } else {
+            float theta = electricField.getOpeningAngle() + (faster ? 0.1f : -0.1f);
+            electricField.setOpeningAngle(std::min(theta, 1.5f));
+            std::cout << "Barnes-Hut theta: " << electricField.getOpeningAngle() << std::endl;
+        }
+    }
+    // Throughput and error of the precision modes, printed to stdout
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        reportFieldPrecision(electricField);
+    }
+    // Timing overlay on/off
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        showProfiler = !showProfiler;
+    }
+    // Back to the original view
+    if (key == GLFW_KEY_HOME && action == GLFW_PRESS) {
+        camera.reset();
+    }
+    // Recent profiling zones as a Chrome trace (open in chrome://tracing or Perfetto)
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        if (Profiler::global().exportChromeTrace("trace.json")) {
+            std::cout << "Profile written to trace.json" << std::endl;
+        } else {
+            std::cerr << "ERROR: Couldn't write trace.json" << std::endl;
+        }
+    }
+    // Cycles how the direct sum treats points next to a charge
+    if (key == GLFW_KEY_S && action == GLFW_PRESS) {
+        switch (electricField.getSofteningMode()) {
+            case SofteningMode::HardCutoff:
+                electricField.setSofteningMode(SofteningMode::Plummer);
+                std::cout << "Softening: Plummer" << std::endl;
+                break;
+            case SofteningMode::Plummer:
+                electricField.setSofteningMode(SofteningMode::None);
+                std::cout << "Softening: none" << std::endl;
+                break;
+            case SofteningMode::None:
+                electricField.setSofteningMode(SofteningMode::HardCutoff);
+                std::cout << "Softening: hard cutoff" << std::endl;
+                break;
+        }
+    }
 }
 
 
@@ -289,9 +550,50 @@ void setupMenu(Menu* menu) {
         electricField.addCharge(x, y, -1.0f);
     });
 
+    menuY -= 50.0f;
+    menu -> addItem("Add continuous source", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        // Cycles wire -> ring -> disk -> plate, each at a random spot
+        static int nextSource = 0;
+        float x = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * 0.6f;
+        float y = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * 0.6f;
+        float charge = (rand() % 2 == 0) ? 2.0f : -2.0f;
+        switch (nextSource) {
+            case 0:
+                electricField.addLineSource(glm::vec2(x - 0.3f, y), glm::vec2(x + 0.3f, y), charge);
+                break;
+            case 1:
+                electricField.addRingSource(glm::vec2(x, y), 0.2f, charge);
+                break;
+            case 2:
+                electricField.addDiskSource(glm::vec2(x, y), 0.15f, charge);
+                break;
+            case 3:
+                electricField.addPolygonSource({glm::vec2(x - 0.2f, y - 0.05f), glm::vec2(x + 0.2f, y - 0.05f),
+                                                glm::vec2(x + 0.2f, y + 0.05f), glm::vec2(x - 0.2f, y + 0.05f)},
+                                               charge);
+                break;
+        }
+        nextSource = (nextSource + 1) % 4;
+    });
+
     menuY -= 50.0f;
     menu -> addItem("Clear charges", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
         electricField.clearCharges();
+        electricField.clearSources();
+    });
+
+    menuY -= 50.0f;
+    menu -> addItem("Save scene", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        if (SceneIO::save(sceneFile, electricField)) {
+            std::cout << "Scene written to " << sceneFile << std::endl;
+        }
+    });
+
+    menuY -= 50.0f;
+    menu -> addItem("Load scene", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        if (SceneIO::load(sceneFile, electricField)) {
+            std::cout << electricField.getCharges().size() << " charges loaded from " << sceneFile << std::endl;
+        }
     });
 
     menuY -= 50.0f;
@@ -307,11 +609,64 @@ void setupMenu(Menu* menu) {
         showMenu = false;
         if (mainMenu) mainMenu -> setVisible(false);
     });
+
+    menuY -= 50.0f;
+    menu -> addItem("Switch field engine", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        // Cycles direct sum -> Barnes-Hut -> multipole
+        switch (electricField.getEngine()) {
+            case FieldEngine::Direct:
+                electricField.setEngine(FieldEngine::BarnesHut);
+                std::cout << "Field engine: Barnes-Hut" << std::endl;
+                break;
+            case FieldEngine::BarnesHut:
+                electricField.setEngine(FieldEngine::Multipole);
+                std::cout << "Field engine: multipole" << std::endl;
+                break;
+            case FieldEngine::Multipole:
+                electricField.setEngine(FieldEngine::Direct);
+                std::cout << "Field engine: direct sum" << std::endl;
+                break;
+        }
+    });
+
+    menuY -= 50.0f;
+    menu -> addItem("Toggle equipotentials", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        showEquipotentials = !showEquipotentials;
+        showMenu = false;
+        if (mainMenu) mainMenu -> setVisible(false);
+    });
+
+    menuY -= 50.0f;
+    menu -> addItem("Toggle field lines", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        showFieldLines = !showFieldLines;
+        showMenu = false;
+        if (mainMenu) mainMenu -> setVisible(false);
+    });
+
+    menuY -= 50.0f;
+    menu -> addItem("Toggle adaptive arrows", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        adaptiveArrows = !adaptiveArrows;
+        std::cout << "Arrows: " << (adaptiveArrows ? "adaptive" : "grid") << std::endl;
+        showMenu = false;
+        if (mainMenu) mainMenu -> setVisible(false);
+    });
+
+    menuY -= 50.0f;
+    menu -> addItem("Toggle dynamics", menuX, menuY, 0.66f, normalColor, hoverColor, []() {
+        runDynamics = !runDynamics;
+        std::cout << "Dynamics: " << (runDynamics ? "on" : "off") << std::endl;
+        showMenu = false;
+        if (mainMenu) mainMenu -> setVisible(false);
+    });
     }
 
 
 
-int main() {
+int main(int argc, char** argv) {
+    // A scene given on the command line is loaded at startup and is where
+    // the menu saves to
+    if (argc > 1) sceneFile = argv[1];
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
@@ -340,7 +695,8 @@ int main() {
     
     glViewport(0, 0, windowWidth, windowHeight);
 
-    GLuint shader = createShaderProgram("shaders/vertex.glsl", "shaders/fragment.glsl");
+    // Arrows are drawn instanced: the vertex shader places each one
+    GLuint shader = createShaderProgram("shaders/arrow_vertex.glsl", "shaders/fragment.glsl");
     if (shader == 0) {
         std::cerr << "Error creating shader program" << std::endl;
         glfwTerminate();
@@ -352,6 +708,7 @@ int main() {
     
     // Create an electric field
     // setupTestCharges(electricField);
+    if (argc > 1) SceneIO::load(sceneFile, electricField);
 
     // Create the charge rendering object
     
@@ -363,9 +720,10 @@ int main() {
         return -1;
     }
     
-    ChargeRenderer chargeRenderer(&textRenderer, window);
+    camera.setViewport(windowWidth, windowHeight);
+    ChargeRenderer chargeRenderer(&textRenderer, &camera);
     // Create the sensor
-    fieldSensor = new Sensor(&textRenderer, window);
+    fieldSensor = new Sensor(&textRenderer, &camera);
     fieldSensor->setPosition(0.0f, 0.0f);  // Default position at center
     
     mainMenu = new Menu(&textRenderer, window);
@@ -377,18 +735,56 @@ int main() {
     glfwSetScrollCallback(window, scroll_callback);
 
     // Choose the vector field to use
-    // Options: rotationalField, cosineField, or electricField.getVectorField()
-    VectorField vectorField = electricField.getVectorField(); 
+    // Options: &rotationalField, &cosineField, or leave it null to draw the
+    // electric field from the incrementally updated grid cache
+    RotationalField rotationalField;
+    CosineField cosineField;
+    const VectorField* vectorField = nullptr;
+
+    // Grid tiles computed in parallel on the shared pool, reused every frame
+    TaskScheduler& scheduler = TaskScheduler::global();
+    std::vector<GridTile> gridTiles;
+
+    // Electric field cached on the grid points; dragging a charge only
+    // applies its old/new contribution instead of recomputing everything
+    FieldGrid fieldGrid;
     
-    // Grid density
+    // Grid density, at zoom 1; zooming scales the spacing with the view so
+    // the number of samples on screen stays the same
     int gridDensity = 25;
     float gridSpacing = 2.0f / gridDensity;
 
-    GLint modelLoc = glGetUniformLocation(shader, "model");
+    // Adaptive arrows: cells from four grid spacings down to half of one,
+    // resampled only when the field or the view changes
+    AdaptiveSampler arrowSampler;
+    arrowSampler.setBudget(800);
+    arrowSampler.setTolerances(0.25f, 0.5f);
+
+    // Potential on a finer grid of its own, contoured into equipotential
+    // lines that are only re-extracted when the potential changes
+    FieldGrid potentialGrid;
+    potentialGrid.setChannels(false, true);
+    Equipotentials equipotentials;
+    LineRenderer equipotentialLines;
+
+    // Field lines traced from the charges, re-traced only when a charge changes
+    FieldLines fieldLines;
+    LineRenderer fieldLineStrips;
+
+    // Charged wires, rings and plates
+    SourceRenderer sourceRenderer;
+
+    // Coulomb N-body mode, stepped at a fixed rate independent of the frame rate
+    ChargeDynamics dynamics;
+
+    // GPU time of the render passes, read back a few frames late
+    GpuTimer gpuTimer;
+    double previousFrameTime = glfwGetTime();
+
     GLint viewLoc = glGetUniformLocation(shader, "view");
     GLint projLoc = glGetUniformLocation(shader, "projection");
     
-    if (modelLoc == -1 || viewLoc == -1 || projLoc == -1) {
+    if (viewLoc == -1 || projLoc == -1) {
         std::cerr << "Error: Couldn't find uniforms" << std::endl;
     }
 
@@ -400,7 +796,7 @@ int main() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Create a fragment shader for charges to visualize them
-    GLuint chargeShader = createShaderProgram("shaders/vertex.glsl", "shaders/charge_fragment.glsl");
+    GLuint chargeShader = createShaderProgram("shaders/charge_vertex.glsl", "shaders/charge_fragment.glsl");
     if (chargeShader == 0) {
     std::cerr << "Error: Could not create charge shader program" << std::endl;
     glfwTerminate();
@@ -478,135 +874,254 @@ int main() {
     
 
     while (!glfwWindowShouldClose(window)) {
-        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // The frame zone closes before endFrame so it lands in this frame
+        {
+            PROFILE_ZONE("Frame");
+            gpuTimer.beginFrame();
+            glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
         
-        // Update projection to keep propotions
-        float aspectRatio = (float)windowWidth / (float)windowHeight;
-        glm::mat4 projection;
+            // Update projection to keep propotions
+            int viewWidth, viewHeight;
+            glfwGetWindowSize(window, &viewWidth, &viewHeight);
+            camera.setViewport(viewWidth, viewHeight);
+            glm::mat4 projection = camera.getProjection();
         
-        if (aspectRatio >= 1.0f) {
-            // Wider window
-            projection = glm::ortho(-1.0f * aspectRatio, 1.0f * aspectRatio, -1.0f, 1.0f);
-        } else {
-            // Higher window
-            projection = glm::ortho(-1.0f, 1.0f, -1.0f / aspectRatio, 1.0f / aspectRatio);
-        }
-        
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
         
-        // Regenarate grid based on the vector field
-        std::vector<glm::vec2> positions;
-        std::vector<glm::vec2> directions;
-        
-        // Get field bounds adjusted for aspect ratio
-        float xMin = -1.0f * aspectRatio;
-        float xMax = 1.0f * aspectRatio;
-        float yMin = -1.0f;
-        float yMax = 1.0f;
+            double frameStart = glfwGetTime();
+            double frameTime = std::min(frameStart - previousFrameTime, 0.1);
+            previousFrameTime = frameStart;
+
+            if (runDynamics) {
+                PROFILE_ZONE("Dynamics");
+                // Same algorithm family as the field: pairwise for the direct
+                // sum, the tree otherwise. The dragged charge stays put.
+                dynamics.setForceEngine(electricField.getEngine() == FieldEngine::Direct
+                                        ? ForceEngine::Direct : ForceEngine::BarnesHut);
+                dynamics.setOpeningAngle(electricField.getOpeningAngle());
+                dynamics.setPinnedCharge(draggingCharge ? selectedChargeIndex : -1);
+                dynamics.advance(electricField, frameTime);
+            } else {
+                dynamics.reset();
+            }
+
+            // Regenarate grid based on the vector field; the arrow lists only
+            // live for this frame
+            FrameArena& frameArena = FrameArena::frame();
+            FrameVector<ArrowInstance> arrows{ArenaAllocator<ArrowInstance>(frameArena)};
         
-        if (aspectRatio < 1.0f) {
-            yMin = -1.0f / aspectRatio;
-            yMax = 1.0f / aspectRatio;
-        }
+            // Field bounds: the visible part of the world, with the sample
+            // spacing following the zoom. Grids start on a multiple of their
+            // spacing so panning keeps the points where they are.
+            WorldRect visible = camera.getVisibleRect();
+            float xMin = visible.xMin;
+            float xMax = visible.xMax;
+            float yMin = visible.yMin;
+            float yMax = visible.yMax;
+            float zoom = camera.getZoom();
+            float spacing = gridSpacing / zoom;
+            float potentialSpacing = spacing / 4.0f;
         
-        for (float x = xMin; x <= xMax; x += gridSpacing) {
-            for (float y = yMin; y <= yMax; y += gridSpacing) {
-                // Skip points very close to charges to avoid extreme vectors
-                bool skipPoint = false;
-                for (const auto& charge : electricField.getCharges()) {
-                    float distSquared = pow(x - charge.position.x, 2) + pow(y - charge.position.y, 2);
-                    if (distSquared < 0.01f) {
-                        skipPoint = true;
-                        break;
-                    }
+            {
+                PROFILE_ZONE("Grid");
+                TaskGroup frameTasks;
+
+                // The sensor reading runs next to the arrows
+                if (fieldSensor && fieldSensor->isActive()) {
+                    scheduler.submit(frameTasks, []() {
+                        fieldSensor->updateFieldVector(electricField);
+                    });
                 }
-                
-                if (skipPoint) continue;
-                
-                positions.emplace_back(x, y);
-                
-                // Get vector field direction
-                glm::vec2 dir = vectorField(x, y);
-                
-                // Calculate magnitude of the field
-                float magnitude = glm::length(dir);
-                
-                // Normalize and scale for visualization
-                // Use a log scale to handle wide range of magnitudes
-                float scaleFactor = 0.05f;
-                if (magnitude > 0.0f) {
-                    scaleFactor += 0.025f * log(1 + magnitude);
+
+                // While charges move every frame the quadtree would be rebuilt
+                // from scratch each frame, so the grid takes over. A drag only
+                // costs the grid a delta per frame; a dynamics step moves
+                // every charge and recomputes the grid in full, but over its
+                // fixed points with no refinement on top.
+                bool fieldMoving = draggingCharge || runDynamics;
+                if (adaptiveArrows && !fieldMoving) {
+                    // Arrows shrink with their cells so neighbours do not overlap
+                    arrowSampler.setCellSizes(4.0f * spacing, 0.5f * spacing);
+                    arrowSampler.setBounds(xMin, xMax, yMin, yMax);
+                    arrowSampler.update(vectorField ? *vectorField : electricField, electricField.getRevision(),
+                                        &electricField, 0.1f);
+                    const std::vector<ArrowSample>& samples = arrowSampler.getSamples();
+                    arrows.reserve(samples.size());
+                    for (const ArrowSample& sample : samples) {
+                        arrows.push_back(makeArrow(sample.position, sample.field,
+                                                   std::min(sample.cellSize / spacing, 2.5f) / zoom));
+                    }
+                    scheduler.wait(frameTasks);
+                } else {
+                    fieldGrid.setLayout(std::floor(xMin / spacing) * spacing, xMax,
+                                        std::floor(yMin / spacing) * spacing, yMax, spacing);
+                    if (!vectorField) {
+                        fieldGrid.sync(electricField);
+                    }
+
+                    // A few tiles per thread so stealing can even out uneven tiles
+                    size_t columnCount = fieldGrid.getColumnCount();
+                    size_t tileCount = std::min(columnCount, static_cast<size_t>(scheduler.getThreadCount()) * 4);
+                    gridTiles.resize(tileCount);
+
+                    for (size_t t = 0; t < tileCount; t++) {
+                        GridTile& tile = gridTiles[t];
+                        tile.columnBegin = columnCount * t / tileCount;
+                        tile.columnEnd = columnCount * (t + 1) / tileCount;
+                        tile.arrowScale = 1.0f / zoom;
+                        tile.vectorField = vectorField;
+                        // Two references fit in std::function without a heap block
+                        scheduler.submit(frameTasks, [&tile, &fieldGrid]() {
+                            computeGridTile(tile, fieldGrid, electricField);
+                        });
+                    }
+                    scheduler.wait(frameTasks);
+
+                    // Merge the tiles in column order
+                    size_t arrowCount = 0;
+                    for (const GridTile& tile : gridTiles) arrowCount += tile.arrows.size();
+                    arrows.reserve(arrowCount);
+                    for (const GridTile& tile : gridTiles) {
+                        arrows.insert(arrows.end(), tile.arrows.begin(), tile.arrows.end());
+                    }
                 }
-                
-                directions.emplace_back(glm::normalize(dir) * scaleFactor);
             }
-        }
+
+            // Continuous sources under the arrows
+            {
+                PROFILE_ZONE("Sources");
+                GpuZone gpuZone(gpuTimer, "Sources");
+                sourceRenderer.draw(electricField.getSources(), sensorShader, projection);
+                glUseProgram(shader);
+            }
         
-        // Draw Arrows
-        for (size_t i = 0; i < positions.size(); ++i) {
-            glm::vec2 pos = positions[i];
-            glm::vec2 dir = directions[i];
-            float angle = atan2(dir.y, dir.x);
-            float magnitude = glm::length(dir);
-
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(pos, 0.0f));
-            model = glm::rotate(model, angle, glm::vec3(0, 0, 1));
-            model = glm::scale(model, glm::vec3(magnitude, magnitude, 1.0f));
-
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            arrow.draw();
-        }
+            // Draw Arrows, all in one instanced call
+            {
+                PROFILE_ZONE("Arrows");
+                GpuZone gpuZone(gpuTimer, "Arrows");
+                arrow.drawInstanced(arrows.data(), arrows.size());
+            }
+
+            if (showEquipotentials) {
+                PROFILE_ZONE("Equipotentials");
+                GpuZone gpuZone(gpuTimer, "Equipotentials");
+                potentialGrid.setLayout(std::floor(xMin / potentialSpacing) * potentialSpacing, xMax,
+                                        std::floor(yMin / potentialSpacing) * potentialSpacing, yMax, potentialSpacing);
+                potentialGrid.sync(electricField);
+                equipotentials.update(potentialGrid);
+                equipotentialLines.upload(equipotentials.getVertices(), equipotentials.getVersion());
+                equipotentialLines.draw(sensorShader, projection, glm::vec3(0.9f, 0.8f, 0.3f));
+            }
 
-        glUseProgram(chargeShader);
-        glUniformMatrix4fv(glGetUniformLocation(chargeShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(chargeShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        chargeRenderer.draw(electricField.getCharges(), chargeShader);
+            if (showFieldLines) {
+                PROFILE_ZONE("Field lines");
+                GpuZone gpuZone(gpuTimer, "Field lines");
+                fieldLines.setBounds(xMin, xMax, yMin, yMax);
+                fieldLines.setTolerance(1e-4f / zoom);
+                fieldLines.update(electricField);
+                fieldLineStrips.upload(fieldLines.getVertices(), fieldLines.getVersion());
+                fieldLineStrips.drawStrips(sensorShader, projection, glm::vec3(0.4f, 0.8f, 1.0f),
+                                           fieldLines.getFirsts(), fieldLines.getCounts());
+            }
 
-        if (mainMenu && showMenu) {
-            mainMenu -> render();
-        }
+            glUseProgram(chargeShader);
+            glUniformMatrix4fv(glGetUniformLocation(chargeShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(chargeShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            {
+                GpuZone gpuZone(gpuTimer, "ChargeRenderer::draw");
+                chargeRenderer.draw(electricField.getCharges(), chargeShader);
+            }
 
-        if (fieldSensor && fieldSensor->isActive()) {
-            // Get view and projection matrices from the current shader
-            glm::mat4 view = glm::mat4(1.0f);
-            glm::mat4 projection = glm::mat4(1.0f);
-            
-            // Update the sensor shader with current view and projection matrices
-            glUseProgram(sensorShader);
-            glUniformMatrix4fv(glGetUniformLocation(sensorShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(sensorShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            if (mainMenu && showMenu) {
+                GpuZone gpuZone(gpuTimer, "Menu::render");
+                mainMenu -> render();
+            }
+
+            if (fieldSensor && fieldSensor->isActive()) {
+                // Update the sensor shader with current view and projection matrices
+                glUseProgram(sensorShader);
+                glUniformMatrix4fv(glGetUniformLocation(sensorShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
+                glUniformMatrix4fv(glGetUniformLocation(sensorShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
             
-            // Update and render the sensor
-            fieldSensor->updateFieldVector(electricField);
-            fieldSensor->render(sensorShader);
-        }
-        
-        double currentTime = glfwGetTime();
-        frameCount++;
-        if (currentTime - lastTime >= 1.0) { // update every second
-            fps = static_cast<float>(frameCount) / (currentTime - lastTime);
-            frameCount = 0;
-            lastTime = currentTime;
-        }
-        std::stringstream ss;
-        ss << "FPS: " << std::fixed << std::setprecision(1) << fps;
-        textRenderer.renderText(ss.str(), 20.0f, windowHeight - ((windowHeight / 2.0f) + 30.0f), 0.75f, glm::vec3(1.0f, 1.0f, 0.0f));
+                // Render the sensor (its reading was updated with the grid tiles)
+                GpuZone gpuZone(gpuTimer, "Sensor::render");
+                fieldSensor->render(sensorShader);
+            }
         
-        textRenderer.renderText("Simulación de cargas eléctricas", 20.0f, 17.5f, 0.66f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRenderer.renderText("Programado por: Rodo Yamazaki", (windowWidth / 2.0f) - 300.0f, 25.0f, 0.5f, glm::vec3(0.7f, 0.7f, 0.7f));
-        textRenderer.renderText("© 2025 - Hokzaap Software", (windowWidth / 2.0f) - 300.0f, 10.0f, 0.5f, glm::vec3(0.7f,0.7f,0.7f));
+            double currentTime = glfwGetTime();
+            frameCount++;
+            if (currentTime - lastTime >= 1.0) { // update every second
+                fps = static_cast<float>(frameCount) / (currentTime - lastTime);
+                frameCount = 0;
+                lastTime = currentTime;
+            }
+            {
+                PROFILE_ZONE("Text");
+                GpuZone gpuZone(gpuTimer, "Text");
+
+                char fpsText[32];
+                std::snprintf(fpsText, sizeof(fpsText), "FPS: %.1f", fps);
+                float overlayY = windowHeight - ((windowHeight / 2.0f) + 30.0f);
+                textRenderer.renderText(fpsText, 20.0f, overlayY, 0.75f, glm::vec3(1.0f, 1.0f, 0.0f));
+
+                // Inclusive ms per frame of each zone (CPU, and GPU for the render
+                // passes), averaged over half a second
+                if (showProfiler) {
+                    char zoneText[96];
+                    for (const Profiler::ZoneTime& zone : Profiler::global().getZoneTimes()) {
+                        overlayY -= 18.0f;
+                        // GPU time next to the CPU time for zones that are also GPU passes
+                        double gpuMilliseconds = gpuTimer.getMilliseconds(zone.name);
+                        if (gpuMilliseconds >= 0.0) {
+                            std::snprintf(zoneText, sizeof(zoneText), "%-24s %7.3f ms  gpu %7.3f ms",
+                                          zone.name, zone.milliseconds, gpuMilliseconds);
+                        } else {
+                            std::snprintf(zoneText, sizeof(zoneText), "%-24s %7.3f ms", zone.name, zone.milliseconds);
+                        }
+                        textRenderer.renderText(zoneText, 20.0f, overlayY, 0.45f, glm::vec3(0.8f, 0.9f, 0.8f));
+                    }
+
+                    // Heap allocations of the previous frame and the zones that made them
+                    if (AllocationTracker::enabled()) {
+                        AllocationTracker::Counts counts = AllocationTracker::getLastFrame();
+                        overlayY -= 18.0f;
+                        std::snprintf(zoneText, sizeof(zoneText), "Allocations: %llu (%.1f KB)",
+                                      static_cast<unsigned long long>(counts.allocations), counts.bytes / 1024.0);
+                        textRenderer.renderText(zoneText, 20.0f, overlayY, 0.45f, glm::vec3(1.0f, 0.7f, 0.6f));
+
+                        AllocationTracker::Site sites[4];
+                        size_t siteCount = AllocationTracker::getLastFrameSites(sites, 4);
+                        for (size_t i = 0; i < siteCount; i++) {
+                            overlayY -= 18.0f;
+                            std::snprintf(zoneText, sizeof(zoneText), "  %-22s %6llu (%.1f KB)", sites[i].zone,
+                                          static_cast<unsigned long long>(sites[i].counts.allocations),
+                                          sites[i].counts.bytes / 1024.0);
+                            textRenderer.renderText(zoneText, 20.0f, overlayY, 0.45f, glm::vec3(1.0f, 0.7f, 0.6f));
+                        }
+                    }
+                }
+
+                textRenderer.renderText("Simulación de cargas eléctricas", 20.0f, 17.5f, 0.66f, glm::vec3(1.0f, 1.0f, 1.0f));
+                textRenderer.renderText("Programado por: Rodo Yamazaki", (windowWidth / 2.0f) - 300.0f, 25.0f, 0.5f, glm::vec3(0.7f, 0.7f, 0.7f));
+                textRenderer.renderText("© 2025 - Hokzaap Software", (windowWidth / 2.0f) - 300.0f, 10.0f, 0.5f, glm::vec3(0.7f,0.7f,0.7f));
+            }
         
         
-        glUseProgram(shader);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            glUseProgram(shader);
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        FrameArena::frame().reset();
+        Profiler::global().endFrame();
+        AllocationTracker::endFrame();
         
         
         //std::cout << "" << std::endl;
     }
 
+    if (AllocationTracker::enabled()) AllocationTracker::report(std::cout);
+
     delete mainMenu;
     delete fieldSensor;
     glfwTerminate();
@@ -0,0 +1,21 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+
+// Per instance: position and unit direction, length and colour ramp position
+layout(location = 1) in vec4 aPlacement;
+layout(location = 2) in vec2 aScaleMagnitude;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out float vMagnitude;
+
+void main() {
+    // Rotate by the direction itself (no angle, no trigonometry)
+    vec2 d = aPlacement.zw;
+    vec2 p = aPos.xy * aScaleMagnitude.x;
+    vec2 world = aPlacement.xy + vec2(d.x * p.x - d.y * p.y, d.y * p.x + d.x * p.y);
+
+    vMagnitude = aScaleMagnitude.y;
+    gl_Position = projection * view * vec4(world, 0.0, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+
+// Per instance: centre, radius and charge
+layout(location = 1) in vec4 aCharge;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out float vCharge;
+
+void main() {
+    vCharge = aCharge.w;
+    gl_Position = projection * view * vec4(aCharge.xy + aPos.xy * aCharge.z, 0.0, 1.0);
+}
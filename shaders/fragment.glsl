@@ -1,6 +1,6 @@
 #version 330 core
 out vec4 FragColor;
-uniform float magnitude;
+in float vMagnitude;
 
 void main() {
     //FragColor = vec4(1.0, 0.7, 0.2, 1.0); //orange
@@ -8,8 +8,8 @@ void main() {
     vec3 color = mix(
         vec3(0.0,0.4,0.8), // low magnitude  (blue)
         vec3(1.0,0.3,0.2), // high magnitude (red)
-        magnitude
+        vMagnitude
     );
 
     FragColor = vec4(color, 1.0);
-}
\ No newline at end of file
+}
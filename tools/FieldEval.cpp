@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ElectricField.hpp"
+#include "SceneIO.hpp"
+#include "TaskScheduler.hpp"
+#include "TiledGridFile.hpp"
+
+// Headless evaluation of the field or the potential on a regular grid.
+//
+//   efield_eval --charges scene.txt --output out.csv
+//               [--bounds xMin xMax yMin yMax] [--size columns rows]
+//               [--quantity field|potential] [--format csv|raw|tiled]
+//               [--tile-size n]
+//               [--engine direct|barnes-hut|multipole] [--theta t] [--order n]
+//               [--softening hard|plummer|none]
+//
+// The charges come from a SceneIO scene: binary (.efs) or text with one
+// "x y q" per line ('#' starts a comment).
+// Sample (c, r) sits at x = xMin + c * (xMax - xMin) / (columns - 1), same
+// for y, and the output is row-major (y outer, x inner). csv writes
+// "x,y,ex,ey" or "x,y,potential" per sample; raw writes bare float32 values
+// (ex, ey interleaved for the field) in the machine's byte order. tiled
+// writes a TiledGridFile (ex, ey, plus the potential with --quantity
+// potential) that readers map instead of loading, for grids larger than RAM.
+// The grid is evaluated in bands of rows spread over every core, so the
+// memory use does not grow with the grid.
+
+namespace {
+    const size_t chunkSize = 1024;          // Samples per task
+    const size_t bandSamples = 1 << 20;     // Samples evaluated before writing
+
+    struct Options {
+        std::string chargesPath;
+        std::string outputPath;
+        float xMin = -1.0f, xMax = 1.0f, yMin = -1.0f, yMax = 1.0f;
+        size_t columns = 512, rows = 512;
+        bool potential = false;
+        bool raw = false;
+        bool tiled = false;
+        uint32_t tileSize = 256;
+        FieldEngine engine = FieldEngine::Direct;
+        float theta = 0.5f;
+        int order = 0;                      // 0 keeps the field's default
+        SofteningMode softening = SofteningMode::HardCutoff;
+    };
+
+    // Fills values for the samples [first, first + count) of the grid
+    void evaluateBand(const ElectricField& field, const Options& options, size_t first, size_t count,
+                      std::vector<float>& xs, std::vector<float>& ys,
+                      std::vector<float>& a, std::vector<float>& b) {
+        xs.resize(count);
+        ys.resize(count);
+        a.resize(count);
+        b.resize(options.potential ? 0 : count);
+
+        float dx = options.columns > 1 ? (options.xMax - options.xMin) / (options.columns - 1) : 0.0f;
+        float dy = options.rows > 1 ? (options.yMax - options.yMin) / (options.rows - 1) : 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            size_t sample = first + i;
+            xs[i] = options.xMin + (sample % options.columns) * dx;
+            ys[i] = options.yMin + (sample / options.columns) * dy;
+        }
+
+        if (!options.potential && field.getEngine() == FieldEngine::Multipole) {
+            // The multipole engine works best with all targets at once
+            field.getFieldAtBatch(xs.data(), ys.data(), count, a.data(), b.data());
+            return;
+        }
+
+        TaskScheduler::global().parallelFor(0, count, chunkSize, [&](size_t begin, size_t end) {
+            if (options.potential) {
+                field.getPotentialAtBatch(xs.data() + begin, ys.data() + begin, end - begin, a.data() + begin);
+            } else {
+                field.getFieldAtBatch(xs.data() + begin, ys.data() + begin, end - begin,
+                                      a.data() + begin, b.data() + begin);
+            }
+        });
+    }
+
+    bool writeBand(std::FILE* out, const Options& options, const std::vector<float>& xs,
+                   const std::vector<float>& ys, const std::vector<float>& a, const std::vector<float>& b) {
+        size_t count = xs.size();
+
+        if (options.raw) {
+            if (options.potential) return std::fwrite(a.data(), sizeof(float), count, out) == count;
+
+            std::vector<float> interleaved(2 * count);
+            for (size_t i = 0; i < count; i++) {
+                interleaved[2 * i] = a[i];
+                interleaved[2 * i + 1] = b[i];
+            }
+            return std::fwrite(interleaved.data(), sizeof(float), 2 * count, out) == 2 * count;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            int written = options.potential
+                ? std::fprintf(out, "%.7g,%.7g,%.9g\n", xs[i], ys[i], a[i])
+                : std::fprintf(out, "%.7g,%.7g,%.9g,%.9g\n", xs[i], ys[i], a[i], b[i]);
+            if (written < 0) return false;
+        }
+        return true;
+    }
+
+    bool writeTiled(const ElectricField& field, const Options& options) {
+        TiledGridLayout layout;
+        layout.xMin = options.xMin;
+        layout.xMax = options.xMax;
+        layout.yMin = options.yMin;
+        layout.yMax = options.yMax;
+        layout.columns = options.columns;
+        layout.rows = options.rows;
+        layout.tileSize = options.tileSize;
+        layout.potential = options.potential;
+
+        auto start = std::chrono::steady_clock::now();
+        if (!TiledGridFile::write(options.outputPath, field, layout)) return false;
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << field.getCharges().size() << " charges, " << options.columns << "x" << options.rows
+                  << " samples in " << options.tileSize << "x" << options.tileSize << " tiles on "
+                  << TaskScheduler::global().getThreadCount() << " threads in " << seconds << " s" << std::endl;
+        return true;
+    }
+
+    bool parseEngine(const char* name, FieldEngine& engine) {
+        if (std::strcmp(name, "direct") == 0) engine = FieldEngine::Direct;
+        else if (std::strcmp(name, "barnes-hut") == 0) engine = FieldEngine::BarnesHut;
+        else if (std::strcmp(name, "multipole") == 0) engine = FieldEngine::Multipole;
+        else return false;
+        return true;
+    }
+
+    bool parseSoftening(const char* name, SofteningMode& mode) {
+        if (std::strcmp(name, "hard") == 0) mode = SofteningMode::HardCutoff;
+        else if (std::strcmp(name, "plummer") == 0) mode = SofteningMode::Plummer;
+        else if (std::strcmp(name, "none") == 0) mode = SofteningMode::None;
+        else return false;
+        return true;
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            // Values that follow arg
+            auto has = [&](int values) { return i + values < argc; };
+
+            if (std::strcmp(arg, "--charges") == 0 && has(1)) {
+                options.chargesPath = argv[++i];
+            } else if (std::strcmp(arg, "--output") == 0 && has(1)) {
+                options.outputPath = argv[++i];
+            } else if (std::strcmp(arg, "--bounds") == 0 && has(4)) {
+                options.xMin = std::strtof(argv[++i], nullptr);
+                options.xMax = std::strtof(argv[++i], nullptr);
+                options.yMin = std::strtof(argv[++i], nullptr);
+                options.yMax = std::strtof(argv[++i], nullptr);
+            } else if (std::strcmp(arg, "--size") == 0 && has(2)) {
+                options.columns = std::strtoull(argv[++i], nullptr, 10);
+                options.rows = std::strtoull(argv[++i], nullptr, 10);
+            } else if (std::strcmp(arg, "--quantity") == 0 && has(1)) {
+                const char* value = argv[++i];
+                if (std::strcmp(value, "field") == 0) options.potential = false;
+                else if (std::strcmp(value, "potential") == 0) options.potential = true;
+                else return false;
+            } else if (std::strcmp(arg, "--format") == 0 && has(1)) {
+                const char* value = argv[++i];
+                options.raw = std::strcmp(value, "raw") == 0;
+                options.tiled = std::strcmp(value, "tiled") == 0;
+                if (!options.raw && !options.tiled && std::strcmp(value, "csv") != 0) return false;
+            } else if (std::strcmp(arg, "--tile-size") == 0 && has(1)) {
+                options.tileSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(arg, "--engine") == 0 && has(1)) {
+                if (!parseEngine(argv[++i], options.engine)) return false;
+            } else if (std::strcmp(arg, "--theta") == 0 && has(1)) {
+                options.theta = std::strtof(argv[++i], nullptr);
+            } else if (std::strcmp(arg, "--order") == 0 && has(1)) {
+                options.order = std::atoi(argv[++i]);
+            } else if (std::strcmp(arg, "--softening") == 0 && has(1)) {
+                if (!parseSoftening(argv[++i], options.softening)) return false;
+            } else {
+                std::cerr << "Unknown or incomplete option " << arg << std::endl;
+                return false;
+            }
+        }
+        return !options.chargesPath.empty() && !options.outputPath.empty()
+            && options.columns > 0 && options.rows > 0 && options.tileSize > 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: efield_eval --charges scene.txt --output out.csv"
+                     " [--bounds xMin xMax yMin yMax] [--size columns rows]"
+                     " [--quantity field|potential] [--format csv|raw|tiled] [--tile-size n]"
+                     " [--engine direct|barnes-hut|multipole] [--theta t] [--order n]"
+                     " [--softening hard|plummer|none]" << std::endl;
+        return 1;
+    }
+
+    ElectricField field;
+    if (!SceneIO::load(options.chargesPath, field)) return 1;
+    field.setEngine(options.engine);
+    field.setOpeningAngle(options.theta);
+    if (options.order > 0) field.setMultipoleOrder(options.order);
+    field.setSofteningMode(options.softening);
+
+    if (options.tiled) return writeTiled(field, options) ? 0 : 1;
+
+    std::FILE* out = std::fopen(options.outputPath.c_str(), options.raw ? "wb" : "w");
+    if (!out) {
+        std::cerr << "Could not open " << options.outputPath << std::endl;
+        return 1;
+    }
+    if (!options.raw) std::fputs(options.potential ? "x,y,potential\n" : "x,y,ex,ey\n", out);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Whole rows per band
+    size_t total = options.columns * options.rows;
+    size_t band = std::max<size_t>(1, bandSamples / options.columns) * options.columns;
+    std::vector<float> xs, ys, a, b;
+    bool ok = true;
+    for (size_t first = 0; first < total && ok; first += band) {
+        size_t count = std::min(band, total - first);
+        evaluateBand(field, options, first, count, xs, ys, a, b);
+        ok = writeBand(out, options, xs, ys, a, b);
+    }
+
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Could not write " << options.outputPath << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << field.getCharges().size() << " charges, " << options.columns << "x" << options.rows
+              << " samples on " << TaskScheduler::global().getThreadCount() << " threads in "
+              << seconds << " s" << std::endl;
+    return 0;
+}